@@ -3,12 +3,15 @@
 //
 
 #include "llvm/Pass.h"
+#include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/IR/Function.h"
 #include "llvm/IR/InstVisitor.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/IR/BasicBlock.h"
 #include "llvm/IR/CFG.h"
 #include "llvm/Transforms/Utils/BasicBlockUtils.h"
+#include "constant_propagation.h"
+#include "value_range.h"
 
 #include <iostream>
 
@@ -167,64 +170,56 @@ namespace {
         }
 
         void constantFold(Function &F) {
+            // 用条件常量传播求出每条指令的值: 不只是两个操作数都是字面常量的指令,
+            // 经过phi, 分支条件以及多条指令传播得到的常量也能被折叠.
+            // 整数区间分析可以进一步折叠结果确定的比较(例如非负数 >= 0)以及区间只有一个值的指令
+            dfa::ConstantPropagation CP;
+            CP.run(F);
+            dfa::ValueRange VR;
+            VR.run(F);
             std::vector<Instruction *> DeadInstrList;
             for (auto &BB : F) {
                 for (auto &Instr : BB) {
-                    if (Instr.getNumOperands() == 2) {
-                        int64_t ConstVal1, ConstVal2;
-                        Value *Opd1 = Instr.getOperand(0);
-                        Value *Opd2 = Instr.getOperand(1);
-                        // get int64 signed for ReplaceInstWithValue
-                        if (isa<ConstantInt>(Opd1)) {
-                            ConstVal1 = dyn_cast<ConstantInt>(Opd1)->getSExtValue();
-                        }
-                        if (isa<ConstantInt>(Opd2)) {
-                            ConstVal2 = dyn_cast<ConstantInt>(Opd2)->getSExtValue();
-                        }
-                        if (isa<ConstantInt>(Opd1) && isa<ConstantInt>(Opd2)) {
-                            //constant folding
-                            bool ConstantFoldFlag = true;
-                            switch (Instr.getOpcode()) {
-                                case Instruction::Add:
-                                    Instr.replaceAllUsesWith(
-                                            ConstantInt::getSigned(Instr.getType(), ConstVal1 + ConstVal2));
-                                    break;
-                                case Instruction::Sub:
-                                    Instr.replaceAllUsesWith(
-                                            ConstantInt::getSigned(Instr.getType(), ConstVal1 + ConstVal2));
-                                    break;
-                                case Instruction::Mul:
-                                    Instr.replaceAllUsesWith(
-                                            ConstantInt::getSigned(Instr.getType(), ConstVal1 * ConstVal2));
-                                    break;
-                                case Instruction::SDiv:
-                                    if (ConstVal2 != 0) {
-                                        Instr.replaceAllUsesWith(
-                                                ConstantInt::getSigned(Instr.getType(), ConstVal1 / ConstVal2));
-                                    } else {
-                                        ConstantFoldFlag = false;
-                                    }
-                                    break;
-                                default:
-                                    ConstantFoldFlag = false;
-                            }
-                            if (ConstantFoldFlag) {
-                                DeadInstrList.push_back(&Instr);
-                                if (DEBUG) {
-                                    outs() << "[CF] ";
-                                    Instr.print(errs());
-                                    outs() << "\n";
-                                }
-                                ++ConstantFoldOptNum;
-                            }
-                        }
+                    if (Instr.getType()->isVoidTy()) {
+                        continue;
+                    }
+                    // 不可执行的基本块中的指令, 以及值不是常量的指令, 返回nullptr
+                    Constant *ConstVal = CP.getConstant(Instr);
+                    if (ConstVal == nullptr) {
+                        ConstVal = VR.getConstant(Instr);
+                    }
+                    if (ConstVal == nullptr) {
+                        continue;
                     }
+                    Instr.replaceAllUsesWith(ConstVal);
+                    DeadInstrList.push_back(&Instr);
+                    if (DEBUG) {
+                        outs() << "[CF] ";
+                        Instr.print(errs());
+                        outs() << "\n";
+                    }
+                    ++ConstantFoldOptNum;
                 }
             }
+            CP.release();
+            VR.release();
             deleteDeadInstrs(DeadInstrList);
         }
 
         void strength(Function &F) {
+            // 有符号除法只有在被除数非负时才能改写为逻辑右移, 由整数区间分析证明.
+            // 必须在任何改写之前判断: 下面Mul改写出的shl是分析没有见过的值
+            dfa::ValueRange VR;
+            VR.run(F);
+            SmallPtrSet<const Instruction *, 8> NonNegSDivs;
+            for (auto &BB : F) {
+                for (auto &Instr : BB) {
+                    if (Instr.getOpcode() == Instruction::SDiv && VR.isKnownNonNegative(Instr.getOperand(0))) {
+                        NonNegSDivs.insert(&Instr);
+                    }
+                }
+            }
+            VR.release();
             std::vector<Instruction *> DeadInstrList;
             for (auto &BB : F) {
                 for (auto &Instr : BB) {
@@ -260,8 +255,9 @@ namespace {
                                 }
                                 break;
                             case Instruction::SDiv:
-                                if (isa<ConstantInt>(Opd2) && getShift(ConstVal2) != -1) {
-                                    // x / 2^n => x >> n
+                                if (isa<ConstantInt>(Opd2) && getShift(ConstVal2) != -1
+                                    && NonNegSDivs.count(&Instr)) {
+                                    // x / 2^n => x >> n, 要求x >= 0
                                     Value *v = ConstantInt::getSigned(Instr.getType(), getShift(ConstVal2));
                                     Instr.replaceAllUsesWith(
                                             BinaryOperator::Create(Instruction::LShr, Opd1, v, "lshr", &Instr));
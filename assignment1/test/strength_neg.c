@@ -0,0 +1,12 @@
+int compute (int a)
+{
+    int result = a * 4;
+    result /= 2;
+    return result;
+}
+
+int main ()
+{
+    // 被除数是mul改写出的shl, 可能为负, sdiv不能改写为lshr
+    return compute(-3) != -6;
+}
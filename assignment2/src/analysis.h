@@ -0,0 +1,146 @@
+//
+// Created by sakura on 2026/10/17.
+//
+
+#ifndef ASSIGNMENT2_ANALYSIS_H
+#define ASSIGNMENT2_ANALYSIS_H
+
+#include <memory>
+
+#include <llvm/IR/Function.h>
+#include <llvm/IR/PassManager.h>
+#include <llvm/Pass.h>
+#include <llvm/Support/TimeProfiler.h>
+#include <llvm/Support/raw_ostream.h>
+#include "framework.h"
+#include "output.h"
+
+namespace dfa {
+    /// @brief 由命令行(-dfa-solver-threads, -dfa-iteration)指定的求解选项
+    SolverOptions SolverOptionsFromCommandLine();
+
+    /// @brief 是否在stderr上报告每个函数的传递函数求值次数, 由-dfa-print-evals指定
+    bool PrintTransferEvaluations();
+
+    // 把一个求解器(Framework的子类)包装成pass. 求解器需要提供:
+    //   void setOptions(const SolverOptions &options);
+    //   void run(const Function &F);
+    //   void release();
+    //   void printInstBVMap(const Function &F, raw_ostream &os) const;
+    //   void writeResults(const Function &F, OutputFormat format, ResultWriter &writer) const;
+
+    /// @brief  按-dfa-output选择的格式把@p analysis 对@p F 的结果写入@p os :
+    ///         Text调用printInstBVMap, Off什么都不写, Binary/JSONL经过ResultWriter调用writeResults
+    template<class TAnalysis>
+    void PrintResults(const TAnalysis &analysis, const llvm::Function &F, llvm::raw_ostream &os) {
+        OutputFormat format = OutputFormatFromCommandLine();
+        llvm::TimeTraceScope scope("DFA Dump", F.getName());
+        switch (format) {
+            case OutputFormat::Text:
+                analysis.printInstBVMap(F, os);
+                break;
+            case OutputFormat::Off:
+                break;
+            case OutputFormat::Binary:
+            case OutputFormat::JSONL: {
+                ResultWriter writer(os);
+                analysis.writeResults(F, format, writer);
+                break;
+            }
+        }
+    }
+
+    /// Legacy Printer Pass
+    ///
+    /// 旧pass manager下的入口: 对每个函数运行@p TAnalysis , 打印结果之后立即释放, 不向其他pass提供结果.
+    template<class TAnalysis>
+    class LegacyPrinterPass final : public llvm::FunctionPass {
+    private:
+        TAnalysis _analysis;
+    public:
+        static char ID;
+
+        LegacyPrinterPass() : llvm::FunctionPass(ID) {}
+
+        virtual ~LegacyPrinterPass() override {}
+
+        // We don't modify the program, so we preserve all analysis.
+        virtual void getAnalysisUsage(llvm::AnalysisUsage &AU) const override {
+            AU.setPreservesAll();
+        }
+
+        virtual bool runOnFunction(llvm::Function &F) override {
+            _analysis.setOptions(SolverOptionsFromCommandLine());
+            _analysis.run(F);
+            if (PrintTransferEvaluations()) {
+                llvm::errs() << F.getName() << ": " << _analysis.numTransferEvaluations() << " transfer evaluations\n";
+            }
+            PrintResults(_analysis, F, ResultStream(llvm::outs()));
+            _analysis.release();
+            return false;
+        }
+    };
+
+    template<class TAnalysis>
+    char LegacyPrinterPass<TAnalysis>::ID = 0;
+
+    /// Cached Analysis Result
+    ///
+    /// 新pass manager下analysis的结果, 持有求解完的@p TAnalysis , 由FunctionAnalysisManager缓存.
+    /// 只有当某个pass修改了IR并且没有声明保留@p TAnalysisPass 时才失效, 下次查询时重新求解.
+    template<class TAnalysis, class TAnalysisPass>
+    class AnalysisResult {
+    private:
+        std::unique_ptr<TAnalysis> _analysis;
+    public:
+        explicit AnalysisResult(std::unique_ptr<TAnalysis> analysis) : _analysis(std::move(analysis)) {}
+
+        const TAnalysis &get() const { return *_analysis; }
+
+        const TAnalysis *operator->() const { return _analysis.get(); }
+
+        bool invalidate(llvm::Function &, const llvm::PreservedAnalyses &PA,
+                        llvm::FunctionAnalysisManager::Invalidator &) {
+            auto checker = PA.getChecker<TAnalysisPass>();
+            return !(checker.preserved() || checker.template preservedSet<llvm::AllAnalysesOn<llvm::Function>>());
+        }
+    };
+
+    /// New-PM Analysis
+    ///
+    /// 新pass manager下的analysis, 其他pass可以通过FAM.getResult<AnalysisPass<TAnalysis>>(F)取得结果并查询.
+    template<class TAnalysis>
+    class AnalysisPass : public llvm::AnalysisInfoMixin<AnalysisPass<TAnalysis>> {
+        friend llvm::AnalysisInfoMixin<AnalysisPass<TAnalysis>>;
+        static llvm::AnalysisKey Key;
+    public:
+        typedef AnalysisResult<TAnalysis, AnalysisPass> Result;
+
+        Result run(llvm::Function &F, llvm::FunctionAnalysisManager &) {
+            std::unique_ptr<TAnalysis> analysis(new TAnalysis());
+            analysis->setOptions(SolverOptionsFromCommandLine());
+            analysis->run(F);
+            return Result(std::move(analysis));
+        }
+    };
+
+    template<class TAnalysis>
+    llvm::AnalysisKey AnalysisPass<TAnalysis>::Key;
+
+    /// New-PM Printer Pass
+    ///
+    /// 从FunctionAnalysisManager取得(可能是缓存的)@p TAnalysisPass 的结果并打印, 输出格式与旧pass相同(同样由-dfa-output选择).
+    template<class TAnalysisPass>
+    class PrinterPass : public llvm::PassInfoMixin<PrinterPass<TAnalysisPass>> {
+    private:
+        llvm::raw_ostream &_os;
+    public:
+        explicit PrinterPass(llvm::raw_ostream &os) : _os(os) {}
+
+        llvm::PreservedAnalyses run(llvm::Function &F, llvm::FunctionAnalysisManager &FAM) {
+            PrintResults(FAM.getResult<TAnalysisPass>(F).get(), F, ResultStream(_os));
+            return llvm::PreservedAnalyses::all();
+        }
+    };
+}
+#endif //ASSIGNMENT2_ANALYSIS_H
@@ -0,0 +1,238 @@
+//
+// Created by sakura on 2026/10/17.
+//
+
+#ifndef ASSIGNMENT2_AVAIL_EXPR_H
+#define ASSIGNMENT2_AVAIL_EXPR_H
+
+#include <functional>
+#include <unordered_map>
+#include <utility>
+
+#include <llvm/ADT/Hashing.h>
+#include <llvm/ADT/SmallVector.h>
+#include <llvm/IR/Instruction.h>
+#include <llvm/IR/Instructions.h>
+#include <llvm/Support/raw_ostream.h>
+#include "analysis.h"
+#include "framework.h"
+
+namespace dfa {
+    /// Expression
+    ///
+    /// 一条没有副作用, 结果只取决于操作数的指令所计算的表达式: 二元运算, 比较, cast和GEP.
+    /// 两个表达式相等当且仅当它们总是计算出相同的值: 操作码相同, 操作数相同(交换律的运算和交换了操作数的比较
+    /// 不区分操作数的顺序), 并且cast的目标类型, GEP的元素类型相同. nsw/exact/inbounds等标志不参与比较.
+    class Expression {
+    private:
+        unsigned _opcode;
+        //比较的谓词, 其他指令为0
+        unsigned _predicate = 0;
+        //结果的类型, 以及GEP的source element type(其他指令为nullptr)
+        const Type *_type;
+        const Type *_source_type = nullptr;
+        SmallVector<const Value *, 2> _operands;
+
+        bool isCompare() const {
+            return _opcode == Instruction::ICmp || _opcode == Instruction::FCmp;
+        }
+
+        /// @brief 操作数的顺序是否可以交换, 比较交换操作数时谓词随之交换
+        bool isSymmetric() const {
+            return Instruction::isCommutative(_opcode) || isCompare();
+        }
+
+    public:
+        /// @brief 指令@p inst 是否计算一个表达式
+        static bool IsExpression(const Instruction &inst) {
+            return isa<BinaryOperator>(inst) || isa<CmpInst>(inst) || isa<CastInst>(inst) ||
+                   isa<GetElementPtrInst>(inst);
+        }
+
+        Expression(const Instruction &inst) : _opcode(inst.getOpcode()), _type(inst.getType()) {
+            if (const auto *cmp = dyn_cast<CmpInst>(&inst)) {
+                _predicate = cmp->getPredicate();
+            } else if (const auto *gep = dyn_cast<GetElementPtrInst>(&inst)) {
+                _source_type = gep->getSourceElementType();
+            }
+            for (const Value *operand : inst.operand_values()) {
+                _operands.push_back(operand);
+            }
+        }
+
+        bool operator==(const Expression &expr) const {
+            if (_opcode != expr._opcode || _type != expr._type || _source_type != expr._source_type ||
+                _operands.size() != expr._operands.size()) {
+                return false;
+            }
+            if (_predicate == expr._predicate && _operands == expr._operands) {
+                return true;
+            }
+            // a op b == b op a, 以及 a < b == b > a
+            if (!isSymmetric() || _operands.size() != 2) {
+                return false;
+            }
+            unsigned swapped = isCompare() ? CmpInst::getSwappedPredicate(CmpInst::Predicate(_predicate)) : 0;
+            return swapped == expr._predicate && _operands[0] == expr._operands[1] &&
+                   _operands[1] == expr._operands[0];
+        }
+
+        /// @brief 与operator==一致的hash: 可交换的两个操作数按地址排序, 比较的谓词随之交换
+        std::size_t hash() const {
+            const Value *lhs = _operands[0];
+            const Value *rhs = _operands.size() > 1 ? _operands[1] : nullptr;
+            unsigned predicate = _predicate;
+            if (isSymmetric() && _operands.size() == 2 && std::less<const Value *>()(rhs, lhs)) {
+                std::swap(lhs, rhs);
+                if (isCompare()) {
+                    predicate = CmpInst::getSwappedPredicate(CmpInst::Predicate(predicate));
+                }
+            }
+            llvm::hash_code code = llvm::hash_combine(_opcode, predicate, _type, _source_type, lhs, rhs);
+            for (unsigned op_idx = 2; op_idx < _operands.size(); ++op_idx) {
+                code = llvm::hash_combine(code, _operands[op_idx]);
+            }
+            return code;
+        }
+
+        unsigned getOpcode() const { return _opcode; }
+
+        const Value *getLHSOperand() const { return _operands[0]; }
+
+        /// @brief 第二个操作数, cast只有一个操作数, 返回nullptr
+        const Value *getRHSOperand() const { return _operands.size() > 1 ? _operands[1] : nullptr; }
+
+        ArrayRef<const Value *> operands() const { return _operands; }
+
+        friend raw_ostream &operator<<(raw_ostream &outs, const Expression &expr) {
+            outs << "[" << Instruction::getOpcodeName(expr._opcode) << " ";
+            if (expr.isCompare()) {
+                outs << CmpInst::getPredicateName(CmpInst::Predicate(expr._predicate)) << " ";
+            }
+            for (unsigned op_idx = 0; op_idx < expr._operands.size(); ++op_idx) {
+                if (op_idx != 0) {
+                    outs << ", ";
+                }
+                expr._operands[op_idx]->printAsOperand(outs, false);
+            }
+            if (Instruction::isCast(expr._opcode)) {
+                outs << " to " << *expr._type;
+            }
+            outs << "]";
+
+            return outs;
+        }
+    };
+}  // namespace dfa
+
+namespace std {
+
+// Construct a hash code for 'Expression'.
+    template<>
+    struct hash<dfa::Expression> {
+        std::size_t operator()(const dfa::Expression &expr) const {
+            return expr.hash();
+        }
+    };
+
+}  // namespace std
+
+namespace dfa {
+    /// Expression Dataflow Framework
+    ///
+    /// 以函数中出现的所有表达式为domain的数据流分析的公共部分: available expressions以及lazy code motion中的各个分析.
+    /// 同一个函数上的这些分析按同样的顺序建立domain, 所以同一个表达式在它们的bitvector中位置相同.
+    /// SSA中一个表达式只会被它的操作数的定值kill, 框架为每个值记录以它为操作数的表达式, 子类在GenKill中使用.
+    template<class TDerived, Direction TDirection, class TMeetOp>
+    class ExpressionFramework : public Framework<TDerived, Expression, TDirection, TMeetOp> {
+    protected:
+        typedef Framework<TDerived, Expression, TDirection, TMeetOp> framework_t;
+        friend framework_t;
+    private:
+        // 反向索引: Value -> 所有以该Value为操作数的表达式的mask,
+        // 某条指令被重新定值时，以它为操作数的表达式都要被kill
+        std::unordered_map<const Value *, BitSet> _kill_index;
+
+    protected:
+        /// @brief 指令@p inst 计算的表达式在domain中的位置, 不计算表达式时返回-1
+        int ExpressionIdx(const Instruction &inst) const {
+            return Expression::IsExpression(inst) ? this->position(Expression(inst)) : -1;
+        }
+
+        /// @brief 把以@p inst 为操作数的表达式, 即@p inst 定值时被kill的表达式加入@p kill
+        void KillOperandsOf(const Instruction &inst, BitSet &kill) const {
+            auto kill_iter = _kill_index.find(&inst);
+            if (kill_iter != _kill_index.end()) {
+                kill |= kill_iter->second;
+            }
+        }
+
+        void InitializeDomainFromInstruction(const Instruction &inst) {
+            // 将所有计算表达式的inst插入_domain中
+            if (Expression::IsExpression(inst)) {
+                Expression expr(inst);
+                unsigned idx = this->_domain.insert(expr);
+                // 同时登记到所有操作数的kill mask里, mask的大小随domain增长
+                for (const Value *operand : expr.operands()) {
+                    BitSet &mask = _kill_index[operand];
+                    if (mask.size() <= idx) {
+                        mask.resize(idx + 1);
+                    }
+                    mask.set(idx);
+                }
+            }
+        }
+
+        void ClearDomain() {
+            framework_t::ClearDomain();
+            _kill_index.clear();
+        }
+    };
+
+    /// Available Expressions
+    ///
+    /// 前向, meet operator为交集, domain为函数中出现的所有表达式(二元运算, 比较, cast和GEP).
+    /// 求解完成后可以查询某个表达式在基本块边界或指令前后是否可用, 不在domain中的表达式总是不可用.
+    class AvailExpr final : public ExpressionFramework<AvailExpr, Direction::Forward, Intersection> {
+        typedef ExpressionFramework<AvailExpr, Direction::Forward, Intersection> base_t;
+        friend base_t;
+        friend base_t::framework_t;
+    protected:
+        BitSet IC() const;
+
+        BitSet BC() const;
+
+        void GenKill(const Instruction &inst, BitSet &gen, BitSet &kill) const;
+
+    public:
+        /// @brief 表达式@p expr 在基本块@p bb 的入口处是否可用
+        bool isAvailableIn(const Expression &expr, const BasicBlock &bb) const {
+            int expr_idx = position(expr);
+            return expr_idx != -1 && BlockIn(bb).test(expr_idx);
+        }
+
+        /// @brief 表达式@p expr 在基本块@p bb 的出口处是否可用
+        bool isAvailableOut(const Expression &expr, const BasicBlock &bb) const {
+            int expr_idx = position(expr);
+            // 前向分析中基本块的state就是出口处的state
+            return expr_idx != -1 && BlockBV(bb).test(expr_idx);
+        }
+
+        /// @brief 表达式@p expr 在指令@p inst 之前是否可用, 例如判断二元运算@p inst 是否冗余:
+        ///        isAvailableBefore(Expression(inst), inst)
+        bool isAvailableBefore(const Expression &expr, const Instruction &inst) const {
+            int expr_idx = position(expr);
+            return expr_idx != -1 && InstIn(inst).test(expr_idx);
+        }
+
+        /// @brief 表达式@p expr 在指令@p inst 之后是否可用
+        bool isAvailableAfter(const Expression &expr, const Instruction &inst) const {
+            int expr_idx = position(expr);
+            return expr_idx != -1 && InstOut(inst).test(expr_idx);
+        }
+    };
+
+    /// @brief 新pass manager下的available expressions analysis, 结果为缓存的dfa::AvailExpr
+    typedef AnalysisPass<AvailExpr> AvailExprAnalysis;
+}
+#endif //ASSIGNMENT2_AVAIL_EXPR_H
@@ -0,0 +1,558 @@
+//
+// Created by sakura on 2026/10/17.
+//
+
+#ifndef ASSIGNMENT2_BITSET_H
+#define ASSIGNMENT2_BITSET_H
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include <llvm/ADT/ArrayRef.h>
+#include <llvm/ADT/iterator_range.h>
+#include <llvm/Support/Allocator.h>
+#include <llvm/Support/MathExtras.h>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace dfa {
+    /***********************************************************************
+     * Word Kernels
+     ***********************************************************************/
+    // 直接作用在word数组上的kernel, 编译时若开启了AVX2则一次处理4个word,
+    // 否则退回SSE2(2个word), 都没有时逐个word处理. 剩余不足一个向量的尾部逐个word处理.
+    namespace kernel {
+        typedef uint64_t word_t;
+
+#if defined(__AVX2__)
+        typedef __m256i vec_t;
+        static constexpr unsigned VecWords = 4;
+
+        inline vec_t Load(const word_t *p) { return _mm256_loadu_si256(reinterpret_cast<const vec_t *>(p)); }
+
+        inline void Store(word_t *p, vec_t v) { _mm256_storeu_si256(reinterpret_cast<vec_t *>(p), v); }
+
+        inline vec_t Or(vec_t a, vec_t b) { return _mm256_or_si256(a, b); }
+
+        inline vec_t And(vec_t a, vec_t b) { return _mm256_and_si256(a, b); }
+
+        inline vec_t Xor(vec_t a, vec_t b) { return _mm256_xor_si256(a, b); }
+
+        /// @brief ~a & b
+        inline vec_t AndNot(vec_t a, vec_t b) { return _mm256_andnot_si256(a, b); }
+
+        inline vec_t Zero() { return _mm256_setzero_si256(); }
+
+        inline bool IsZero(vec_t v) { return _mm256_testz_si256(v, v) != 0; }
+#elif defined(__SSE2__)
+        typedef __m128i vec_t;
+        static constexpr unsigned VecWords = 2;
+
+        inline vec_t Load(const word_t *p) { return _mm_loadu_si128(reinterpret_cast<const vec_t *>(p)); }
+
+        inline void Store(word_t *p, vec_t v) { _mm_storeu_si128(reinterpret_cast<vec_t *>(p), v); }
+
+        inline vec_t Or(vec_t a, vec_t b) { return _mm_or_si128(a, b); }
+
+        inline vec_t And(vec_t a, vec_t b) { return _mm_and_si128(a, b); }
+
+        inline vec_t Xor(vec_t a, vec_t b) { return _mm_xor_si128(a, b); }
+
+        inline vec_t AndNot(vec_t a, vec_t b) { return _mm_andnot_si128(a, b); }
+
+        inline vec_t Zero() { return _mm_setzero_si128(); }
+
+        // SSE2没有ptest, 用逐字节比较代替
+        inline bool IsZero(vec_t v) { return _mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_setzero_si128())) == 0xFFFF; }
+#else
+        typedef word_t vec_t;
+        static constexpr unsigned VecWords = 1;
+
+        inline vec_t Load(const word_t *p) { return *p; }
+
+        inline void Store(word_t *p, vec_t v) { *p = v; }
+
+        inline vec_t Or(vec_t a, vec_t b) { return a | b; }
+
+        inline vec_t And(vec_t a, vec_t b) { return a & b; }
+
+        inline vec_t Xor(vec_t a, vec_t b) { return a ^ b; }
+
+        inline vec_t AndNot(vec_t a, vec_t b) { return ~a & b; }
+
+        inline vec_t Zero() { return 0; }
+
+        inline bool IsZero(vec_t v) { return v == 0; }
+#endif
+
+        /// @brief 按位或, 同时提供向量与标量两个版本, 作为MeetN的模板参数
+        struct OrOp {
+            static vec_t Apply(vec_t a, vec_t b) { return Or(a, b); }
+
+            static word_t ApplyWord(word_t a, word_t b) { return a | b; }
+        };
+
+        /// @brief 按位与
+        struct AndOp {
+            static vec_t Apply(vec_t a, vec_t b) { return And(a, b); }
+
+            static word_t ApplyWord(word_t a, word_t b) { return a & b; }
+        };
+
+        /// @brief dst = srcs[0] op srcs[1] op ... op srcs[n-1], 只扫描一遍word数组, 不产生临时对象.
+        ///        要求@p nsrcs > 0.
+        template<class TOp>
+        inline void MeetN(word_t *dst, const word_t *const *srcs, unsigned nsrcs, unsigned nwords) {
+            assert(nsrcs > 0);
+            unsigned i = 0;
+            for (; i + VecWords <= nwords; i += VecWords) {
+                vec_t acc = Load(srcs[0] + i);
+                for (unsigned s = 1; s < nsrcs; ++s) {
+                    acc = TOp::Apply(acc, Load(srcs[s] + i));
+                }
+                Store(dst + i, acc);
+            }
+            for (; i < nwords; ++i) {
+                word_t acc = srcs[0][i];
+                for (unsigned s = 1; s < nsrcs; ++s) {
+                    acc = TOp::ApplyWord(acc, srcs[s][i]);
+                }
+                dst[i] = acc;
+            }
+        }
+
+        /// @brief dst = (srcs[0] - kills[0]) op (srcs[1] - kills[1]) op ..., 每个operand在读入时
+        ///        先和自己的kill做一次AND-NOT, 仍然只扫描一遍word数组. 要求@p nsrcs > 0.
+        template<class TOp>
+        inline void MeetMaskedN(word_t *dst, const word_t *const *srcs, const word_t *const *kills,
+                                unsigned nsrcs, unsigned nwords) {
+            assert(nsrcs > 0);
+            unsigned i = 0;
+            for (; i + VecWords <= nwords; i += VecWords) {
+                vec_t acc = AndNot(Load(kills[0] + i), Load(srcs[0] + i));
+                for (unsigned s = 1; s < nsrcs; ++s) {
+                    acc = TOp::Apply(acc, AndNot(Load(kills[s] + i), Load(srcs[s] + i)));
+                }
+                Store(dst + i, acc);
+            }
+            for (; i < nwords; ++i) {
+                word_t acc = srcs[0][i] & ~kills[0][i];
+                for (unsigned s = 1; s < nsrcs; ++s) {
+                    acc = TOp::ApplyWord(acc, srcs[s][i] & ~kills[s][i]);
+                }
+                dst[i] = acc;
+            }
+        }
+
+        /// @brief dst = (in - kill) ∪ gen, 在同一个循环里完成写回与变化检测.
+        ///        @p dst 与@p in 可以是同一个数组.
+        /// @return dst是否被改变
+        inline bool Transfer(word_t *dst, const word_t *in, const word_t *gen, const word_t *kill,
+                             unsigned nwords) {
+            unsigned i = 0;
+            vec_t diff = Zero();
+            for (; i + VecWords <= nwords; i += VecWords) {
+                vec_t next = Or(AndNot(Load(kill + i), Load(in + i)), Load(gen + i));
+                diff = Or(diff, Xor(next, Load(dst + i)));
+                Store(dst + i, next);
+            }
+            word_t diff_word = 0;
+            for (; i < nwords; ++i) {
+                word_t next = (in[i] & ~kill[i]) | gen[i];
+                diff_word |= next ^ dst[i];
+                dst[i] = next;
+            }
+            return !IsZero(diff) || diff_word != 0;
+        }
+
+        inline void OrInto(word_t *dst, const word_t *src, unsigned nwords) {
+            unsigned i = 0;
+            for (; i + VecWords <= nwords; i += VecWords) {
+                Store(dst + i, Or(Load(dst + i), Load(src + i)));
+            }
+            for (; i < nwords; ++i) {
+                dst[i] |= src[i];
+            }
+        }
+
+        inline void AndInto(word_t *dst, const word_t *src, unsigned nwords) {
+            unsigned i = 0;
+            for (; i + VecWords <= nwords; i += VecWords) {
+                Store(dst + i, And(Load(dst + i), Load(src + i)));
+            }
+            for (; i < nwords; ++i) {
+                dst[i] &= src[i];
+            }
+        }
+
+        /// @brief dst = dst - src
+        inline void AndNotInto(word_t *dst, const word_t *src, unsigned nwords) {
+            unsigned i = 0;
+            for (; i + VecWords <= nwords; i += VecWords) {
+                Store(dst + i, AndNot(Load(src + i), Load(dst + i)));
+            }
+            for (; i < nwords; ++i) {
+                dst[i] &= ~src[i];
+            }
+        }
+    }
+
+    /***********************************************************************
+     * BitSet
+     ***********************************************************************/
+    /// Dense Bit Set
+    ///
+    /// 定长的稠密bitset, 用作框架中的state/gen/kill. 所有按位运算都经过上面的kernel.
+    /// 不变式: 超出size()的尾部bit总是0, 因此可以按word直接比较.
+    ///
+    /// BitSet可以自己拥有word数组, 也可以是指向外部内存(例如BitMatrix的某一行)的视图.
+    /// 视图的大小不可改变, 对视图赋值只会拷贝word, 不会改变其指向的内存.
+    class BitSet {
+    public:
+        typedef kernel::word_t word_t;
+        static constexpr unsigned WordBits = 64;
+
+        static unsigned NumWords(unsigned size) { return (size + WordBits - 1) / WordBits; }
+
+    private:
+        word_t *_words = nullptr;
+        unsigned _size = 0;
+        bool _owned = true;
+
+        /// @brief 清掉超出size()的尾部bit, 维持不变式
+        void clearUnusedBits() {
+            unsigned used = _size % WordBits;
+            if (used != 0) {
+                _words[numWords() - 1] &= ~word_t(0) >> (WordBits - used);
+            }
+        }
+
+    public:
+        BitSet() = default;
+
+        explicit BitSet(unsigned size, bool value = false) : _size(size) {
+            if (numWords() != 0) {
+                _words = new word_t[numWords()];
+            }
+            value ? set() : reset();
+        }
+
+        BitSet(const BitSet &other) : _size(other._size) {
+            if (numWords() != 0) {
+                _words = new word_t[numWords()];
+                std::memcpy(_words, other._words, numWords() * sizeof(word_t));
+            }
+        }
+
+        BitSet(BitSet &&other) noexcept : _words(other._words), _size(other._size), _owned(other._owned) {
+            other._words = nullptr;
+            other._size = 0;
+            other._owned = true;
+        }
+
+        /// @brief 构造一个指向@p storage 的视图, @p storage 至少要有NumWords(@p size)个word
+        static BitSet View(word_t *storage, unsigned size) {
+            BitSet view;
+            view._words = storage;
+            view._size = size;
+            view._owned = false;
+            return view;
+        }
+
+        BitSet &operator=(const BitSet &other) {
+            if (this == &other) {
+                return *this;
+            }
+            if (!_owned) {
+                assert(other._size == _size && "Cannot resize a BitSet view.");
+            } else if (numWords() != other.numWords()) {
+                delete[] _words;
+                _words = other.numWords() != 0 ? new word_t[other.numWords()] : nullptr;
+            }
+            _size = other._size;
+            if (numWords() != 0) {
+                std::memcpy(_words, other._words, numWords() * sizeof(word_t));
+            }
+            return *this;
+        }
+
+        BitSet &operator=(BitSet &&other) noexcept {
+            // 只要有一方是视图就退化为拷贝, 保证视图始终指向原来的内存
+            if (!_owned || !other._owned) {
+                return *this = static_cast<const BitSet &>(other);
+            }
+            std::swap(_words, other._words);
+            std::swap(_size, other._size);
+            return *this;
+        }
+
+        ~BitSet() {
+            if (_owned) {
+                delete[] _words;
+            }
+        }
+
+        unsigned size() const { return _size; }
+
+        unsigned numWords() const { return NumWords(_size); }
+
+        /// @brief word数组占用的字节数
+        size_t bytes() const { return size_t(numWords()) * sizeof(word_t); }
+
+        const word_t *words() const { return _words; }
+
+        word_t *words() { return _words; }
+
+        /// @brief 改变大小, 新增的bit为0
+        void resize(unsigned size) {
+            if (size == _size) {
+                return;
+            }
+            assert(_owned && "Cannot resize a BitSet view.");
+            if (NumWords(size) != numWords()) {
+                word_t *words = NumWords(size) != 0 ? new word_t[NumWords(size)] : nullptr;
+                unsigned common = std::min(NumWords(size), numWords());
+                if (common != 0) {
+                    std::memcpy(words, _words, common * sizeof(word_t));
+                }
+                std::fill(words + common, words + NumWords(size), 0);
+                delete[] _words;
+                _words = words;
+            }
+            _size = size;
+            clearUnusedBits();
+        }
+
+        bool test(unsigned idx) const {
+            assert(idx < _size && "BitSet index out of range.");
+            return (_words[idx / WordBits] >> (idx % WordBits)) & 1;
+        }
+
+        bool operator[](unsigned idx) const { return test(idx); }
+
+        BitSet &set(unsigned idx) {
+            assert(idx < _size && "BitSet index out of range.");
+            _words[idx / WordBits] |= word_t(1) << (idx % WordBits);
+            return *this;
+        }
+
+        BitSet &reset(unsigned idx) {
+            assert(idx < _size && "BitSet index out of range.");
+            _words[idx / WordBits] &= ~(word_t(1) << (idx % WordBits));
+            return *this;
+        }
+
+        /// @brief 将所有bit置1
+        BitSet &set() {
+            std::fill(_words, _words + numWords(), ~word_t(0));
+            clearUnusedBits();
+            return *this;
+        }
+
+        /// @brief 将所有bit置0
+        BitSet &reset() {
+            std::fill(_words, _words + numWords(), 0);
+            return *this;
+        }
+
+        /// @brief *this = *this - @p mask
+        BitSet &reset(const BitSet &mask) {
+            assert(mask._size == _size);
+            kernel::AndNotInto(_words, mask._words, numWords());
+            return *this;
+        }
+
+        /// @brief *this = *this ∪ @p other, @p other 可以比*this短(视为高位补0)
+        BitSet &operator|=(const BitSet &other) {
+            assert(other._size <= _size);
+            kernel::OrInto(_words, other._words, other.numWords());
+            return *this;
+        }
+
+        BitSet &operator&=(const BitSet &other) {
+            assert(other._size == _size);
+            kernel::AndInto(_words, other._words, numWords());
+            return *this;
+        }
+
+        bool operator==(const BitSet &other) const {
+            return _size == other._size &&
+                   (numWords() == 0 || std::memcmp(_words, other._words, numWords() * sizeof(word_t)) == 0);
+        }
+
+        bool operator!=(const BitSet &other) const { return !(*this == other); }
+
+        bool any() const {
+            return std::any_of(_words, _words + numWords(), [](word_t w) { return w != 0; });
+        }
+
+        unsigned count() const {
+            unsigned num = 0;
+            for (unsigned i = 0; i < numWords(); ++i) {
+                num += llvm::countPopulation(_words[i]);
+            }
+            return num;
+        }
+
+        /// @brief 返回@p prev 之后(不含)第一个为1的bit, 没有则返回-1; @p prev 为-1时从头开始
+        int findNext(int prev) const {
+            unsigned idx = prev + 1;
+            if (idx >= _size) {
+                return -1;
+            }
+            unsigned word_idx = idx / WordBits;
+            word_t word = _words[word_idx] & (~word_t(0) << (idx % WordBits));
+            while (word == 0) {
+                if (++word_idx == numWords()) {
+                    return -1;
+                }
+                word = _words[word_idx];
+            }
+            return word_idx * WordBits + llvm::countTrailingZeros(word);
+        }
+
+        int findFirst() const { return findNext(-1); }
+
+        /// @brief 遍历所有为1的bit的下标
+        class const_set_bits_iterator {
+        private:
+            const BitSet *_parent;
+            int _current;
+        public:
+            const_set_bits_iterator(const BitSet *parent, int current) : _parent(parent), _current(current) {}
+
+            unsigned operator*() const { return _current; }
+
+            const_set_bits_iterator &operator++() {
+                _current = _parent->findNext(_current);
+                return *this;
+            }
+
+            bool operator==(const const_set_bits_iterator &other) const { return _current == other._current; }
+
+            bool operator!=(const const_set_bits_iterator &other) const { return _current != other._current; }
+        };
+
+        llvm::iterator_range<const_set_bits_iterator> set_bits() const {
+            return llvm::make_range(const_set_bits_iterator(this, findFirst()),
+                                    const_set_bits_iterator(this, -1));
+        }
+
+        /// @brief *this = (@p in - @p kill) ∪ @p gen, 与变化检测融合在一起
+        /// @return *this是否被改变
+        bool assignTransfer(const BitSet &in, const BitSet &gen, const BitSet &kill) {
+            assert(in._size == _size && gen._size == _size && kill._size == _size);
+            return kernel::Transfer(_words, in._words, gen._words, kill._words, numWords());
+        }
+
+        /// @brief *this = @p operands[0] op @p operands[1] op ..., 要求@p operands 非空
+        template<class TOp>
+        void assignMeet(llvm::ArrayRef<const BitSet *> operands) {
+            assert(!operands.empty());
+            // 最常见的情况是只有一两个operand, 用栈上的数组收集word指针
+            const word_t *small_srcs[8];
+            std::unique_ptr<const word_t *[]> large_srcs;
+            const word_t **srcs = small_srcs;
+            if (operands.size() > 8) {
+                large_srcs.reset(new const word_t *[operands.size()]);
+                srcs = large_srcs.get();
+            }
+            for (unsigned i = 0; i < operands.size(); ++i) {
+                assert(operands[i]->_size == _size);
+                srcs[i] = operands[i]->_words;
+            }
+            kernel::MeetN<TOp>(_words, srcs, operands.size(), numWords());
+        }
+
+        /// @brief *this = (@p operands[0] - @p kills[0]) op (@p operands[1] - @p kills[1]) op ...,
+        ///        要求@p operands 非空且与@p kills 一一对应
+        template<class TOp>
+        void assignMeetMasked(llvm::ArrayRef<const BitSet *> operands, llvm::ArrayRef<const BitSet *> kills) {
+            assert(!operands.empty() && operands.size() == kills.size());
+            const word_t *small_srcs[16];
+            std::unique_ptr<const word_t *[]> large_srcs;
+            const word_t **srcs = small_srcs;
+            if (operands.size() > 8) {
+                large_srcs.reset(new const word_t *[2 * operands.size()]);
+                srcs = large_srcs.get();
+            }
+            // 前一半存放operand, 后一半存放对应的kill
+            const word_t **kill_srcs = srcs + operands.size();
+            for (unsigned i = 0; i < operands.size(); ++i) {
+                assert(operands[i]->_size == _size && kills[i]->_size == _size);
+                srcs[i] = operands[i]->_words;
+                kill_srcs[i] = kills[i]->_words;
+            }
+            kernel::MeetMaskedN<TOp>(_words, srcs, kill_srcs, operands.size(), numWords());
+        }
+    };
+
+    /***********************************************************************
+     * Bit Matrix
+     ***********************************************************************/
+    /// Arena-backed Bit Matrix
+    ///
+    /// 所有行的word连续存放在从arena一次性分配的内存中, 第i行即编号为i的程序点(基本块或指令)的state.
+    /// 每一行以BitSet视图的形式给出, 行首按向量宽度对齐. 内存随arena一起释放, BitMatrix自身不负责释放.
+    class BitMatrix {
+    private:
+        std::vector<BitSet> _rows;
+        size_t _bytes = 0;
+    public:
+        typedef BitSet::word_t word_t;
+
+        /// @brief 从@p arena 中分配@p num_rows 行, 每行@p row_bits 个bit, 所有bit初始化为@p value
+        void allocate(llvm::BumpPtrAllocator &arena, unsigned num_rows, unsigned row_bits, bool value = false) {
+            // 行宽补齐到向量宽度的整数倍, 使每一行的起始地址都对齐
+            unsigned row_stride = llvm::alignTo(BitSet::NumWords(row_bits), kernel::VecWords);
+            _bytes = size_t(num_rows) * row_stride * sizeof(word_t);
+            word_t *storage = static_cast<word_t *>(
+                    arena.Allocate(std::max<size_t>(_bytes, sizeof(word_t)), llvm::Align(kernel::VecWords * sizeof(word_t))));
+            _rows.clear();
+            _rows.reserve(num_rows);
+            for (unsigned i = 0; i < num_rows; ++i) {
+                _rows.push_back(BitSet::View(storage + size_t(i) * row_stride, row_bits));
+                value ? _rows.back().set() : _rows.back().reset();
+            }
+        }
+
+        /// @brief 丢弃所有行的视图, 之后需要由arena统一释放内存
+        void clear() {
+            _rows.clear();
+            _bytes = 0;
+        }
+
+        BitSet &operator[](unsigned row) {
+            assert(row < _rows.size() && "BitMatrix row out of range.");
+            return _rows[row];
+        }
+
+        const BitSet &operator[](unsigned row) const {
+            assert(row < _rows.size() && "BitMatrix row out of range.");
+            return _rows[row];
+        }
+
+        /// @brief 返回从第@p start 行开始的连续@p num 行
+        llvm::MutableArrayRef<BitSet> slice(unsigned start, unsigned num) {
+            assert(start + num <= _rows.size() && "BitMatrix row out of range.");
+            return llvm::MutableArrayRef<BitSet>(_rows.data() + start, num);
+        }
+
+        unsigned rows() const { return _rows.size(); }
+
+        bool empty() const { return _rows.empty(); }
+
+        /// @brief 矩阵本身占用的字节数(不含行视图)
+        size_t bytes() const { return _bytes; }
+    };
+}
+#endif //ASSIGNMENT2_BITSET_H
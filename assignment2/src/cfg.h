@@ -0,0 +1,495 @@
+//
+// Created by sakura on 2026/10/17.
+//
+
+#ifndef ASSIGNMENT2_CFG_H
+#define ASSIGNMENT2_CFG_H
+
+#include <algorithm>
+#include <cassert>
+#include <utility>
+#include <vector>
+
+#include <llvm/ADT/ArrayRef.h>
+#include <llvm/ADT/DenseMap.h>
+#include <llvm/IR/BasicBlock.h>
+#include <llvm/IR/CFG.h>
+#include <llvm/IR/Function.h>
+#include <llvm/IR/Instruction.h>
+
+namespace dfa {
+    /// Flat CFG Snapshot
+    ///
+    /// 在求解之前把函数的CFG一次性拍成以稠密编号索引的扁平数组, 求解器的迭代只访问这些整数数组,
+    /// 不再遍历LLVM的侵入式链表, 也不再经过terminator的use-list去找前驱后继。
+    ///   - 基本块按build时给出的顺序从0开始编号;
+    ///   - 前驱/后继以CSR(compressed sparse row)的形式存放, 第i个基本块的后继为
+    ///     _succs[_succ_offsets[i], _succ_offsets[i + 1]), 前驱同理;
+    ///   - 边按其在_preds(或_succs)中的下标编号, 可以用来索引每条边上的附加数据;
+    ///   - 每个基本块的指令按布局顺序占据_insts中连续的一段, 指令的编号即其在_insts中的下标。
+    /// 快照不会跟踪IR的修改: CFG发生变化后需要重新build, 只有指令发生变化时可以refreshInsts.
+    class CFGSnapshot {
+    private:
+        std::vector<const llvm::BasicBlock *> _blocks;
+        llvm::DenseMap<const llvm::BasicBlock *, unsigned> _index;
+        std::vector<unsigned> _pred_offsets, _preds;
+        std::vector<unsigned> _succ_offsets, _succs;
+        std::vector<unsigned> _inst_offsets;
+        std::vector<const llvm::Instruction *> _insts;
+    public:
+        /// @brief 按@p order 给基本块编号并建立快照, @p order 必须恰好包含函数的所有基本块
+        void build(llvm::ArrayRef<const llvm::BasicBlock *> order) {
+            clear();
+            _blocks.assign(order.begin(), order.end());
+            unsigned num_blocks = _blocks.size();
+            for (unsigned bb_idx = 0; bb_idx < num_blocks; ++bb_idx) {
+                _index[_blocks[bb_idx]] = bb_idx;
+            }
+            // 后继按terminator中的顺序存放, 同一条边出现多次时(例如switch的多个case)保留重复
+            _succ_offsets.reserve(num_blocks + 1);
+            _inst_offsets.reserve(num_blocks + 1);
+            for (const llvm::BasicBlock *bb : _blocks) {
+                _succ_offsets.push_back(_succs.size());
+                for (const llvm::BasicBlock *succ : llvm::successors(bb)) {
+                    _succs.push_back(index(*succ));
+                }
+                _inst_offsets.push_back(_insts.size());
+                for (const llvm::Instruction &inst : *bb) {
+                    _insts.push_back(&inst);
+                }
+            }
+            _succ_offsets.push_back(_succs.size());
+            _inst_offsets.push_back(_insts.size());
+            // 前驱由后继转置得到: 先数出每个基本块的入度, 前缀和之后再依次填入
+            _pred_offsets.assign(num_blocks + 1, 0);
+            for (unsigned succ : _succs) {
+                ++_pred_offsets[succ + 1];
+            }
+            for (unsigned bb_idx = 0; bb_idx < num_blocks; ++bb_idx) {
+                _pred_offsets[bb_idx + 1] += _pred_offsets[bb_idx];
+            }
+            _preds.resize(_succs.size());
+            std::vector<unsigned> fill(_pred_offsets.begin(), _pred_offsets.end() - 1);
+            for (unsigned bb_idx = 0; bb_idx < num_blocks; ++bb_idx) {
+                for (unsigned succ : succs(bb_idx)) {
+                    _preds[fill[succ]++] = bb_idx;
+                }
+            }
+        }
+
+        /// @brief 基本块和边不变, 只按现在的IR重新收集每个基本块的指令, 指令的编号随之改变
+        void refreshInsts() {
+            _inst_offsets.clear();
+            _insts.clear();
+            _inst_offsets.reserve(_blocks.size() + 1);
+            for (const llvm::BasicBlock *bb : _blocks) {
+                _inst_offsets.push_back(_insts.size());
+                for (const llvm::Instruction &inst : *bb) {
+                    _insts.push_back(&inst);
+                }
+            }
+            _inst_offsets.push_back(_insts.size());
+        }
+
+        /// @brief 快照中的基本块和边(包括后继的顺序)是否与@p F 现在的CFG一致
+        bool matches(const llvm::Function &F) const {
+            if (F.size() != _blocks.size()) {
+                return false;
+            }
+            for (const llvm::BasicBlock &bb : F) {
+                auto iter = _index.find(&bb);
+                if (iter == _index.end()) {
+                    return false;
+                }
+                llvm::ArrayRef<unsigned> snapshot_succs = succs(iter->second);
+                unsigned succ_idx = 0;
+                for (const llvm::BasicBlock *succ : llvm::successors(&bb)) {
+                    auto succ_iter = _index.find(succ);
+                    if (succ_idx == snapshot_succs.size() || succ_iter == _index.end() ||
+                        succ_iter->second != snapshot_succs[succ_idx]) {
+                        return false;
+                    }
+                    ++succ_idx;
+                }
+                if (succ_idx != snapshot_succs.size()) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        /// @brief @p bb 是否属于快照
+        bool contains(const llvm::BasicBlock &bb) const {
+            return _index.count(&bb) != 0;
+        }
+
+        void clear() {
+            _blocks.clear();
+            _index.clear();
+            _pred_offsets.clear();
+            _preds.clear();
+            _succ_offsets.clear();
+            _succs.clear();
+            _inst_offsets.clear();
+            _insts.clear();
+        }
+
+        /// @brief 基本块的数量
+        unsigned size() const { return _blocks.size(); }
+
+        bool empty() const { return _blocks.empty(); }
+
+        /// @brief 编号为@p bb_idx 的基本块
+        const llvm::BasicBlock *block(unsigned bb_idx) const {
+            assert(bb_idx < _blocks.size() && "Basic block index out of range.");
+            return _blocks[bb_idx];
+        }
+
+        /// @brief 所有基本块, 按编号排列
+        llvm::ArrayRef<const llvm::BasicBlock *> blocks() const { return _blocks; }
+
+        /// @brief 基本块@p bb 的编号
+        unsigned index(const llvm::BasicBlock &bb) const {
+            auto iter = _index.find(&bb);
+            assert(iter != _index.end() && "Basic block does not belong to the snapshot.");
+            return iter->second;
+        }
+
+        /// @brief 编号为@p bb_idx 的基本块的所有前驱的编号
+        llvm::ArrayRef<unsigned> preds(unsigned bb_idx) const {
+            return llvm::makeArrayRef(_preds).slice(_pred_offsets[bb_idx],
+                                                    _pred_offsets[bb_idx + 1] - _pred_offsets[bb_idx]);
+        }
+
+        /// @brief 编号为@p bb_idx 的基本块的所有后继的编号
+        llvm::ArrayRef<unsigned> succs(unsigned bb_idx) const {
+            return llvm::makeArrayRef(_succs).slice(_succ_offsets[bb_idx],
+                                                    _succ_offsets[bb_idx + 1] - _succ_offsets[bb_idx]);
+        }
+
+        /// @brief 边的总数
+        unsigned numEdges() const { return _succs.size(); }
+
+        /// @brief 编号为@p bb_idx 的基本块的入边在_preds中的起始位置, 第k条入边即preds(bb_idx)[k]
+        unsigned predBegin(unsigned bb_idx) const { return _pred_offsets[bb_idx]; }
+
+        /// @brief 编号为@p bb_idx 的基本块的出边在_succs中的起始位置, 第k条出边即succs(bb_idx)[k]
+        unsigned succBegin(unsigned bb_idx) const { return _succ_offsets[bb_idx]; }
+
+        /// @brief 编号为@p bb_idx 的基本块的第一条指令的编号
+        unsigned instBegin(unsigned bb_idx) const { return _inst_offsets[bb_idx]; }
+
+        /// @brief 编号为@p bb_idx 的基本块的所有指令, 按布局顺序排列
+        llvm::ArrayRef<const llvm::Instruction *> insts(unsigned bb_idx) const {
+            return llvm::makeArrayRef(_insts).slice(_inst_offsets[bb_idx],
+                                                    _inst_offsets[bb_idx + 1] - _inst_offsets[bb_idx]);
+        }
+
+        /// @brief 所有指令, 按编号排列
+        llvm::ArrayRef<const llvm::Instruction *> insts() const { return _insts; }
+
+        /// @brief 指令的总数
+        unsigned numInsts() const { return _insts.size(); }
+    };
+
+    /// Strongly Connected Components of a CFG Snapshot
+    ///
+    /// 把CFG快照的基本块划分为强连通分量(SCC), 分量之间的边构成一个DAG(condensation).
+    ///   - 边的方向由build的@p forward 决定: true时沿后继(数据从前驱流向后继, 即前向分析), 否则沿前驱;
+    ///   - 分量按DAG的拓扑序从0开始编号, 分量的所有DAG前驱的编号都小于它;
+    ///   - 分量内的基本块按其在快照中的编号升序排列;
+    ///   - 分量之间的DAG边已去重, 以CSR形式存放.
+    /// 沿着DAG的拓扑序, 每个分量只依赖于编号更小的分量, 没有先后关系的分量可以各自独立地求解.
+    class SCCPartition {
+    private:
+        std::vector<unsigned> _scc_of;
+        std::vector<unsigned> _member_offsets, _members;
+        std::vector<unsigned> _dag_offsets, _dag_succs;
+        std::vector<unsigned> _num_dag_preds;
+
+        static llvm::ArrayRef<unsigned> Edges(const CFGSnapshot &cfg, unsigned bb_idx, bool forward) {
+            return forward ? cfg.succs(bb_idx) : cfg.preds(bb_idx);
+        }
+
+    public:
+        /// @brief 用迭代版本的Tarjan算法划分@p cfg , 不使用递归, 基本块再多也不会爆栈
+        void build(const CFGSnapshot &cfg, bool forward) {
+            const unsigned unvisited = ~0u;
+            unsigned num_blocks = cfg.size();
+            std::vector<unsigned> dfs_idx(num_blocks, unvisited), low(num_blocks);
+            std::vector<bool> on_stack(num_blocks, false);
+            std::vector<unsigned> stack;
+            //DFS的调用栈: (基本块, 下一条要访问的边)
+            std::vector<std::pair<unsigned, unsigned>> frames;
+            //Tarjan按逆拓扑序依次产生分量, 先按产生的顺序记录, 最后再反转编号
+            std::vector<unsigned> emitted_offsets, emitted;
+            unsigned counter = 0;
+            for (unsigned root = 0; root < num_blocks; ++root) {
+                if (dfs_idx[root] != unvisited) {
+                    continue;
+                }
+                dfs_idx[root] = low[root] = counter++;
+                stack.push_back(root);
+                on_stack[root] = true;
+                frames.emplace_back(root, 0);
+                while (!frames.empty()) {
+                    unsigned bb_idx = frames.back().first;
+                    llvm::ArrayRef<unsigned> edges = Edges(cfg, bb_idx, forward);
+                    if (frames.back().second < edges.size()) {
+                        unsigned next = edges[frames.back().second++];
+                        if (dfs_idx[next] == unvisited) {
+                            dfs_idx[next] = low[next] = counter++;
+                            stack.push_back(next);
+                            on_stack[next] = true;
+                            frames.emplace_back(next, 0);
+                        } else if (on_stack[next]) {
+                            low[bb_idx] = std::min(low[bb_idx], dfs_idx[next]);
+                        }
+                        continue;
+                    }
+                    frames.pop_back();
+                    if (!frames.empty()) {
+                        unsigned parent = frames.back().first;
+                        low[parent] = std::min(low[parent], low[bb_idx]);
+                    }
+                    if (low[bb_idx] != dfs_idx[bb_idx]) {
+                        continue;
+                    }
+                    // bb_idx是一个分量的根, 栈中它之上的基本块都属于这个分量
+                    emitted_offsets.push_back(emitted.size());
+                    unsigned member;
+                    do {
+                        member = stack.back();
+                        stack.pop_back();
+                        on_stack[member] = false;
+                        emitted.push_back(member);
+                    } while (member != bb_idx);
+                }
+            }
+            emitted_offsets.push_back(emitted.size());
+
+            unsigned num_sccs = emitted_offsets.size() - 1;
+            _scc_of.assign(num_blocks, 0);
+            _member_offsets.clear();
+            _members.clear();
+            _member_offsets.reserve(num_sccs + 1);
+            _members.reserve(num_blocks);
+            for (unsigned scc = 0; scc < num_sccs; ++scc) {
+                unsigned emitted_idx = num_sccs - 1 - scc;
+                _member_offsets.push_back(_members.size());
+                _members.insert(_members.end(), emitted.begin() + emitted_offsets[emitted_idx],
+                                emitted.begin() + emitted_offsets[emitted_idx + 1]);
+                std::sort(_members.begin() + _member_offsets.back(), _members.end());
+                for (unsigned k = _member_offsets.back(); k < _members.size(); ++k) {
+                    _scc_of[_members[k]] = scc;
+                }
+            }
+            _member_offsets.push_back(_members.size());
+
+            // 分量之间的边, last_seen记录每个目标分量最近一次被哪个源分量加入过, 用来去重
+            _dag_offsets.clear();
+            _dag_succs.clear();
+            _dag_offsets.reserve(num_sccs + 1);
+            _num_dag_preds.assign(num_sccs, 0);
+            std::vector<unsigned> last_seen(num_sccs, unvisited);
+            for (unsigned scc = 0; scc < num_sccs; ++scc) {
+                _dag_offsets.push_back(_dag_succs.size());
+                for (unsigned bb_idx : members(scc)) {
+                    for (unsigned next : Edges(cfg, bb_idx, forward)) {
+                        unsigned next_scc = _scc_of[next];
+                        if (next_scc != scc && last_seen[next_scc] != scc) {
+                            last_seen[next_scc] = scc;
+                            _dag_succs.push_back(next_scc);
+                            ++_num_dag_preds[next_scc];
+                        }
+                    }
+                }
+            }
+            _dag_offsets.push_back(_dag_succs.size());
+        }
+
+        /// @brief 分量的数量
+        unsigned size() const { return _member_offsets.empty() ? 0 : _member_offsets.size() - 1; }
+
+        /// @brief 编号为@p bb_idx 的基本块所在的分量
+        unsigned sccOf(unsigned bb_idx) const { return _scc_of[bb_idx]; }
+
+        /// @brief 分量@p scc 中的所有基本块, 按基本块的编号升序排列
+        llvm::ArrayRef<unsigned> members(unsigned scc) const {
+            return llvm::makeArrayRef(_members).slice(_member_offsets[scc],
+                                                      _member_offsets[scc + 1] - _member_offsets[scc]);
+        }
+
+        /// @brief 直接依赖于分量@p scc 的所有分量
+        llvm::ArrayRef<unsigned> dagSuccs(unsigned scc) const {
+            return llvm::makeArrayRef(_dag_succs).slice(_dag_offsets[scc],
+                                                        _dag_offsets[scc + 1] - _dag_offsets[scc]);
+        }
+
+        /// @brief 分量@p scc 直接依赖的分量的个数
+        unsigned numDAGPreds(unsigned scc) const { return _num_dag_preds[scc]; }
+    };
+
+    /// Weak Topological Order (Bourdoncle)
+    ///
+    /// 把CFG快照的基本块排成一个带嵌套括号的序列, 例如 0 (1 2 (3 4) 5) 6: 每对括号是一个分量(大致对应一个循环),
+    /// 括号里的第一个基本块是分量的head, 分量内部的每个环都经过head. 求解时按序列的顺序求值,
+    /// 每个分量先在内部迭代到稳定再继续往后, 内层循环稳定之后外层循环才向外传播.
+    ///   - 边的方向由build的@p forward 决定, 与SCCPartition相同;
+    ///   - 序列按位置展平存放在_order中, head所在的位置记录其分量的结束位置(不含).
+    class WeakTopologicalOrder {
+    private:
+        std::vector<unsigned> _order;
+        std::vector<unsigned> _component_end;
+        std::vector<bool> _is_head;
+
+        static llvm::ArrayRef<unsigned> Edges(const CFGSnapshot &cfg, unsigned bb_idx, bool forward) {
+            return forward ? cfg.succs(bb_idx) : cfg.preds(bb_idx);
+        }
+
+        //DFS的调用栈: Visit为Bourdoncle算法中的visit(v), Component为component(v)
+        struct Frame {
+            enum Kind {
+                Visit, Component
+            } kind;
+            unsigned bb_idx;
+            unsigned edge_pos;
+            unsigned head;
+            bool loop;
+            //Component: 分量开始时_order(逆序)的长度
+            unsigned start;
+        };
+
+    public:
+        /// @brief  用迭代版本的Bourdoncle算法计算@p cfg 的WTO. DFS先从边界(沿分析方向没有入边的基本块,
+        ///         前向为entry, 后向为出口)出发, 再按编号的顺序从剩下的基本块出发.
+        ///         算法中"插入到partition最前面"的操作在这里是追加到逆序的序列末尾, 最后整体反转.
+        void build(const CFGSnapshot &cfg, bool forward) {
+            const unsigned done = ~0u;
+            unsigned num_blocks = cfg.size();
+            std::vector<unsigned> dfn(num_blocks, 0);
+            std::vector<unsigned> stack;
+            std::vector<Frame> frames;
+            //逆序的WTO, 以及每个分量在逆序中的[start, end)
+            std::vector<unsigned> reversed;
+            std::vector<std::pair<unsigned, unsigned>> components;
+            reversed.reserve(num_blocks);
+            unsigned num = 0;
+
+            auto push_visit = [&](unsigned bb_idx) {
+                stack.push_back(bb_idx);
+                dfn[bb_idx] = ++num;
+                frames.push_back({Frame::Visit, bb_idx, 0, dfn[bb_idx], false, 0});
+            };
+            std::vector<unsigned> roots;
+            roots.reserve(num_blocks);
+            for (unsigned bb_idx = 0; bb_idx < num_blocks; ++bb_idx) {
+                if (Edges(cfg, bb_idx, !forward).empty()) {
+                    roots.push_back(bb_idx);
+                }
+            }
+            for (unsigned bb_idx = 0; bb_idx < num_blocks; ++bb_idx) {
+                roots.push_back(bb_idx);
+            }
+            for (unsigned root : roots) {
+                if (dfn[root] != 0) {
+                    continue;
+                }
+                push_visit(root);
+                //刚刚返回的visit(w)的结果
+                unsigned ret = 0;
+                bool returned = false;
+                while (!frames.empty()) {
+                    Frame &frame = frames.back();
+                    llvm::ArrayRef<unsigned> edges = Edges(cfg, frame.bb_idx, forward);
+                    if (frame.kind == Frame::Visit) {
+                        if (returned) {
+                            returned = false;
+                            if (ret <= frame.head) {
+                                frame.head = ret;
+                                frame.loop = true;
+                            }
+                        }
+                        if (frame.edge_pos < edges.size()) {
+                            unsigned next = edges[frame.edge_pos++];
+                            if (dfn[next] == 0) {
+                                push_visit(next);
+                            } else if (dfn[next] <= frame.head) {
+                                frame.head = dfn[next];
+                                frame.loop = true;
+                            }
+                            continue;
+                        }
+                        if (frame.head == dfn[frame.bb_idx]) {
+                            dfn[frame.bb_idx] = done;
+                            unsigned elem = stack.back();
+                            stack.pop_back();
+                            if (frame.loop) {
+                                while (elem != frame.bb_idx) {
+                                    dfn[elem] = 0;
+                                    elem = stack.back();
+                                    stack.pop_back();
+                                }
+                                // 原地变为component(v), 它结束时才把v放入序列
+                                frame.kind = Frame::Component;
+                                frame.edge_pos = 0;
+                                frame.start = reversed.size();
+                                continue;
+                            }
+                            reversed.push_back(frame.bb_idx);
+                        }
+                        ret = frame.head;
+                        returned = true;
+                        frames.pop_back();
+                    } else {
+                        // component(v)忽略visit(w)的返回值
+                        returned = false;
+                        if (frame.edge_pos < edges.size()) {
+                            unsigned next = edges[frame.edge_pos++];
+                            if (dfn[next] == 0) {
+                                push_visit(next);
+                            }
+                            continue;
+                        }
+                        reversed.push_back(frame.bb_idx);
+                        components.emplace_back(frame.start, reversed.size());
+                        // 作为visit(v)返回, 此时head即v原来的dfn
+                        ret = frame.head;
+                        returned = true;
+                        frames.pop_back();
+                    }
+                }
+            }
+
+            unsigned size = reversed.size();
+            _order.assign(reversed.rbegin(), reversed.rend());
+            _component_end.resize(size);
+            _is_head.assign(size, false);
+            for (unsigned pos = 0; pos < size; ++pos) {
+                _component_end[pos] = pos + 1;
+            }
+            // 逆序中的[start, end)对应正序中的[size - end, size - start), head位于最前面
+            for (const auto &component : components) {
+                unsigned head_pos = size - component.second;
+                _is_head[head_pos] = true;
+                _component_end[head_pos] = size - component.first;
+            }
+        }
+
+        /// @brief 序列的长度, 即基本块的数量
+        unsigned size() const { return _order.size(); }
+
+        /// @brief 序列中第@p pos 个基本块的编号
+        unsigned operator[](unsigned pos) const { return _order[pos]; }
+
+        /// @brief 第@p pos 个基本块是否是某个分量的head
+        bool isHead(unsigned pos) const { return _is_head[pos]; }
+
+        /// @brief 以第@p pos 个基本块为head的分量的结束位置(不含), 分量占据[pos, componentEnd(pos))
+        unsigned componentEnd(unsigned pos) const {
+            assert(isHead(pos) && "Only the head of a component has a component end.");
+            return _component_end[pos];
+        }
+    };
+}
+#endif //ASSIGNMENT2_CFG_H
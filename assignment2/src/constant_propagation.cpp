@@ -0,0 +1,87 @@
+//
+// Created by sakura on 2026/10/17.
+//
+
+// 常量传播本身不注册pass, 这样assignment1中的LocalOpts也可以直接编译这个文件来使用它,
+// 打印pass以及折叠常量, 删除不可达基本块的transform(-dfa-sccp)见sccp.cpp.
+
+#include <algorithm>
+
+#include <llvm/Analysis/ConstantFolding.h>
+#include <llvm/IR/Constants.h>
+#include <llvm/IR/Instructions.h>
+#include <llvm/IR/Module.h>
+#include "constant_propagation.h"
+
+using namespace llvm;
+using dfa::ConstantValue;
+
+namespace dfa {
+    ConstantValue ConstantPropagation::Transfer(const Instruction &inst) const {
+        // 有副作用或者读内存的指令的结果不是常量
+        if (inst.mayHaveSideEffects() || inst.mayReadFromMemory() || inst.isTerminator()) {
+            return ConstantValue::overdefined();
+        }
+        SmallVector<Constant *, 4> operands;
+        for (const Use &op : inst.operands()) {
+            ConstantValue value = getValue(op.get());
+            // 任何一个操作数还是Undefined, 乐观地认为结果也是Undefined
+            if (value.isUndefined()) {
+                return ConstantValue();
+            }
+            if (value.isOverdefined()) {
+                return ConstantValue::overdefined();
+            }
+            operands.push_back(value.getConstant());
+        }
+        const DataLayout &DL = inst.getModule()->getDataLayout();
+        Constant *folded;
+        if (const auto *cmp = dyn_cast<CmpInst>(&inst)) {
+            folded = ConstantFoldCompareInstOperands(cmp->getPredicate(), operands[0], operands[1], DL);
+        } else {
+            // ConstantFoldInstOperands不会修改指令, 只是参数没有声明为const
+            folded = ConstantFoldInstOperands(const_cast<Instruction *>(&inst), operands, DL);
+        }
+        return folded != nullptr ? ConstantValue::get(folded) : ConstantValue::overdefined();
+    }
+
+    ConstantValue ConstantPropagation::ValueOf(const Value &val) const {
+        if (const auto *constant = dyn_cast<Constant>(&val)) {
+            return ConstantValue::get(const_cast<Constant *>(constant));
+        }
+        // 函数参数等
+        return ConstantValue::overdefined();
+    }
+
+    void ConstantPropagation::FeasibleSuccessors(const Instruction &term, SmallVectorImpl<bool> &feasible) const {
+        const Value *cond = nullptr;
+        if (const auto *br = dyn_cast<BranchInst>(&term)) {
+            if (br->isConditional()) {
+                cond = br->getCondition();
+            }
+        } else if (const auto *sw = dyn_cast<SwitchInst>(&term)) {
+            cond = sw->getCondition();
+        }
+        if (cond == nullptr) {
+            // 无条件跳转以及其他terminator, 所有后继都可执行
+            std::fill(feasible.begin(), feasible.end(), true);
+            return;
+        }
+        ConstantValue value = getValue(cond);
+        // 条件还没有被执行到时哪一侧都不可执行
+        if (value.isUndefined()) {
+            return;
+        }
+        const auto *cond_const = dyn_cast_or_null<ConstantInt>(value.getConstant());
+        if (cond_const == nullptr) {
+            std::fill(feasible.begin(), feasible.end(), true);
+            return;
+        }
+        if (isa<BranchInst>(term)) {
+            // 条件为true时跳转到第0个后继
+            feasible[cond_const->isZero() ? 1 : 0] = true;
+            return;
+        }
+        feasible[cast<SwitchInst>(term).findCaseValue(cond_const)->getSuccessorIndex()] = true;
+    }
+}
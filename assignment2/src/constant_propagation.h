@@ -0,0 +1,107 @@
+//
+// Created by sakura on 2026/10/17.
+//
+
+#ifndef ASSIGNMENT2_CONSTANT_PROPAGATION_H
+#define ASSIGNMENT2_CONSTANT_PROPAGATION_H
+
+#include <llvm/IR/Constant.h>
+#include <llvm/IR/Instruction.h>
+#include <llvm/Support/raw_ostream.h>
+#include "lattice.h"
+
+namespace dfa {
+    /// Constant Lattice
+    ///
+    /// 常量传播的格: Undefined(Top, 还没有被执行到) > 某个常量 > Overdefined(Bottom, 不是常量).
+    /// LLVM中的常量是唯一化的, 两个格元素是同一个常量当且仅当指针相同.
+    class ConstantValue {
+    public:
+        enum Kind {
+            Undefined, Constant, Overdefined
+        };
+    private:
+        Kind _kind = Undefined;
+        llvm::Constant *_constant = nullptr;
+    public:
+        ConstantValue() = default;
+
+        static ConstantValue get(llvm::Constant *constant) {
+            ConstantValue value;
+            value._kind = Constant;
+            value._constant = constant;
+            return value;
+        }
+
+        static ConstantValue overdefined() {
+            ConstantValue value;
+            value._kind = Overdefined;
+            return value;
+        }
+
+        bool isUndefined() const { return _kind == Undefined; }
+
+        bool isConstant() const { return _kind == Constant; }
+
+        bool isOverdefined() const { return _kind == Overdefined; }
+
+        /// @brief 常量的值, 只有isConstant()时不为nullptr
+        llvm::Constant *getConstant() const { return _constant; }
+
+        bool meet(const ConstantValue &other) {
+            if (other._kind == Undefined || _kind == Overdefined || *this == other) {
+                return false;
+            }
+            *this = _kind == Undefined ? other : overdefined();
+            return true;
+        }
+
+        bool operator==(const ConstantValue &other) const {
+            return _kind == other._kind && _constant == other._constant;
+        }
+
+        bool operator!=(const ConstantValue &other) const { return !(*this == other); }
+
+        friend llvm::raw_ostream &operator<<(llvm::raw_ostream &outs, const ConstantValue &value) {
+            switch (value._kind) {
+                case Undefined:
+                    outs << "undefined";
+                    break;
+                case Constant:
+                    outs << "const ";
+                    value._constant->printAsOperand(outs, false);
+                    break;
+                case Overdefined:
+                    outs << "overdefined";
+                    break;
+            }
+            return outs;
+        }
+    };
+
+    /// Sparse Conditional Constant Propagation
+    ///
+    /// 稀疏, 条件的常量传播: 操作数都是常量的指令用LLVM的常量折叠求值, 经过phi和分支传播的常量也能被发现;
+    /// 条件为常量的分支只有一侧可执行, 从不可执行的边流入phi的值被忽略.
+    /// 求解完成后, 可执行基本块中格元素为常量的指令可以被替换为该常量, 不可执行的基本块可以被删除.
+    class ConstantPropagation final : public LatticeFramework<ConstantPropagation, ConstantValue> {
+        typedef LatticeFramework<ConstantPropagation, ConstantValue> base_t;
+        friend base_t;
+    protected:
+        ConstantValue Transfer(const Instruction &inst) const;
+
+        ConstantValue ValueOf(const Value &val) const;
+
+        void FeasibleSuccessors(const Instruction &term, SmallVectorImpl<bool> &feasible) const;
+
+    public:
+        /// @brief 指令@p inst 是否可以被替换为常量, 是的话返回该常量, 否则返回nullptr
+        llvm::Constant *getConstant(const Instruction &inst) const {
+            if (!isExecutable(*inst.getParent())) {
+                return nullptr;
+            }
+            return getValue(inst).getConstant();
+        }
+    };
+}
+#endif //ASSIGNMENT2_CONSTANT_PROPAGATION_H
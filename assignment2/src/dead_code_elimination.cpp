@@ -0,0 +1,125 @@
+//
+// Created by sakura on 2026/10/17.
+//
+
+// 由faint variables(strong liveness)驱动的激进死代码消除:
+//   opt -load libAssignment2.so -dfa-adce input.ll -S -o output.ll
+//   opt -load-pass-plugin=libAssignment2.so -passes='dfa-adce' input.ll -S -o output.ll
+
+#include <vector>
+
+#include <llvm/ADT/DenseSet.h>
+#include <llvm/ADT/Statistic.h>
+#include <llvm/IR/Constants.h>
+#include <llvm/IR/InstIterator.h>
+#include <llvm/Pass.h>
+#include <llvm/Transforms/Utils/Local.h>
+#include "dead_code_elimination.h"
+#include "liveness.h"
+
+#define DEBUG_TYPE "dfa-adce"
+
+using namespace llvm;
+
+STATISTIC(NumRemoved, "Number of dead instructions removed");
+STATISTIC(NumRounds, "Number of incremental liveness updates until the fixed point");
+
+namespace {
+    class LegacyAggressiveDCEPass final : public FunctionPass {
+    public:
+        static char ID;
+
+        LegacyAggressiveDCEPass() : FunctionPass(ID) {}
+
+        virtual ~LegacyAggressiveDCEPass() override {}
+
+        virtual void getAnalysisUsage(AnalysisUsage &AU) const override {
+            AU.setPreservesCFG();
+        }
+
+        virtual bool runOnFunction(Function &F) override {
+            return dfa::RunAggressiveDeadCodeElimination(F) != 0;
+        }
+    };
+
+    char LegacyAggressiveDCEPass::ID = 0;
+
+    RegisterPass<LegacyAggressiveDCEPass> X(
+            "dfa-adce", "Aggressive Dead Code Elimination (driven by Faint Variables)");
+} // namespace anonymous
+
+namespace dfa {
+    unsigned RunAggressiveDeadCodeElimination(Function &F) {
+        // 乐观地假设所有没有副作用的指令都是faint, 结果在strong liveness下活跃的指令移出集合,
+        // 它们的use随之使操作数活跃, 如此反复直到不动点, 剩下的就是最大的faint集合.
+        // 互相使用的phi在开始时都是faint, 它们之间的use不会使对方活跃, 所以整个环一起被删除
+        std::vector<Instruction *> candidates;
+        DenseSet<const Instruction *> faint;
+        for (Instruction &inst : instructions(F)) {
+            if (wouldInstructionBeTriviallyDead(&inst)) {
+                candidates.push_back(&inst);
+                faint.insert(&inst);
+            }
+        }
+        Liveness liveness;
+        liveness.setFaintInstructions(&faint);
+        liveness.run(F);
+        // 第一轮检查所有候选, 之后只有刚刚变为活跃的指令的操作数才可能变为活跃
+        std::vector<const Instruction *> worklist(candidates.begin(), candidates.end());
+        while (true) {
+            std::vector<const Instruction *> live;
+            for (const Instruction *inst : worklist) {
+                if (faint.count(inst) && liveness.isLiveAfter(inst, *inst)) {
+                    live.push_back(inst);
+                }
+            }
+            if (live.empty()) {
+                break;
+            }
+            // 只有这些指令的gen改变, 增量地更新上一次的结果
+            worklist.clear();
+            for (const Instruction *inst : live) {
+                faint.erase(inst);
+                liveness.transferChanged(*inst);
+            }
+            for (const Instruction *inst : live) {
+                for (const Value *operand : inst->operand_values()) {
+                    const auto *operand_inst = dyn_cast<Instruction>(operand);
+                    if (operand_inst != nullptr && faint.count(operand_inst)) {
+                        worklist.push_back(operand_inst);
+                    }
+                }
+            }
+            liveness.update(F);
+            ++NumRounds;
+        }
+        liveness.release();
+
+        std::vector<Instruction *> dead;
+        for (Instruction *inst : candidates) {
+            if (faint.count(inst)) {
+                dead.push_back(inst);
+            }
+        }
+        // 剩下的use要么来自其他faint指令, 要么位于不可达的基本块中(活跃性不会从那里传播到定义), 都可以替换为poison
+        for (Instruction *inst : dead) {
+            if (!inst->use_empty()) {
+                inst->replaceAllUsesWith(PoisonValue::get(inst->getType()));
+            }
+        }
+        for (Instruction *inst : dead) {
+            inst->eraseFromParent();
+        }
+        NumRemoved += dead.size();
+        return dead.size();
+    }
+
+    PreservedAnalyses AggressiveDCEPass::run(Function &F, FunctionAnalysisManager &) {
+        if (RunAggressiveDeadCodeElimination(F) == 0) {
+            return PreservedAnalyses::all();
+        }
+        PreservedAnalyses PA;
+        PA.preserveSet<CFGAnalyses>();
+        return PA;
+    }
+}
@@ -0,0 +1,22 @@
+//
+// Created by sakura on 2026/10/17.
+//
+
+#ifndef ASSIGNMENT2_DEAD_CODE_ELIMINATION_H
+#define ASSIGNMENT2_DEAD_CODE_ELIMINATION_H
+
+#include <llvm/IR/Function.h>
+#include <llvm/IR/PassManager.h>
+
+namespace dfa {
+    /// @brief  对@p F 运行基于faint variables的激进死代码消除: 结果不会(直接或间接地)到达任何副作用,
+    ///         terminator的指令都被删除, 包括循环中互相使用的phi. 不改变CFG, 返回被删除的指令数
+    unsigned RunAggressiveDeadCodeElimination(llvm::Function &F);
+
+    /// New-PM Aggressive Dead Code Elimination Pass
+    class AggressiveDCEPass : public llvm::PassInfoMixin<AggressiveDCEPass> {
+    public:
+        llvm::PreservedAnalyses run(llvm::Function &F, llvm::FunctionAnalysisManager &);
+    };
+}
+#endif //ASSIGNMENT2_DEAD_CODE_ELIMINATION_H
@@ -0,0 +1,122 @@
+//
+// Created by sakura on 2026/10/17.
+//
+
+// 由memory liveness驱动的死存储消除:
+//   opt -load libAssignment2.so -dfa-dse input.ll -S -o output.ll
+//   opt -load-pass-plugin=libAssignment2.so -passes='dfa-dse' input.ll -S -o output.ll
+// 被删除的store写入的值可能随之变为无用, 可以再运行-dfa-adce删除它们.
+
+#include <vector>
+
+#include <llvm/ADT/SmallVector.h>
+#include <llvm/ADT/Statistic.h>
+#include <llvm/IR/InstIterator.h>
+#include <llvm/IR/Instructions.h>
+#include <llvm/Pass.h>
+#include "dead_store_elimination.h"
+#include "memory_liveness.h"
+
+#define DEBUG_TYPE "dfa-dse"
+
+using namespace llvm;
+
+STATISTIC(NumStoresRemoved, "Number of dead stores removed");
+STATISTIC(NumSlotsRemoved, "Number of allocas removed because they are never read");
+
+namespace {
+    /// @brief  如果不逃逸的@p alloca 已经没有任何load/store, 删除它以及由它派生的指针和lifetime intrinsic.
+    /// @return 是否删除了@p alloca
+    bool RemoveUnusedSlot(AllocaInst &alloca) {
+        SmallVector<Instruction *, 8> derived{&alloca};
+        SmallVector<Instruction *, 4> markers;
+        for (unsigned ptr_idx = 0; ptr_idx < derived.size(); ++ptr_idx) {
+            for (User *user : derived[ptr_idx]->users()) {
+                auto *user_inst = cast<Instruction>(user);
+                if (isa<LoadInst>(user_inst) || isa<StoreInst>(user_inst)) {
+                    return false;
+                }
+                // 不逃逸的alloca的其他user只有bitcast/GEP以及lifetime intrinsic
+                if (isa<BitCastInst>(user_inst) || isa<GetElementPtrInst>(user_inst)) {
+                    derived.push_back(user_inst);
+                } else {
+                    markers.push_back(user_inst);
+                }
+            }
+        }
+        for (Instruction *marker : markers) {
+            marker->eraseFromParent();
+        }
+        // 派生的指针按发现的逆序删除, 先删除user再删除被使用的指针
+        for (auto ptr_iter = derived.rbegin(); ptr_iter != derived.rend(); ++ptr_iter) {
+            (*ptr_iter)->eraseFromParent();
+        }
+        return true;
+    }
+
+    class LegacyDeadStoreEliminationPass final : public FunctionPass {
+    public:
+        static char ID;
+
+        LegacyDeadStoreEliminationPass() : FunctionPass(ID) {}
+
+        virtual ~LegacyDeadStoreEliminationPass() override {}
+
+        virtual void getAnalysisUsage(AnalysisUsage &AU) const override {
+            AU.setPreservesCFG();
+        }
+
+        virtual bool runOnFunction(Function &F) override {
+            return dfa::RunDeadStoreElimination(F);
+        }
+    };
+
+    char LegacyDeadStoreEliminationPass::ID = 0;
+
+    RegisterPass<LegacyDeadStoreEliminationPass> X(
+            "dfa-dse", "Dead Store Elimination (driven by Memory Liveness)");
+} // namespace anonymous
+
+namespace dfa {
+    bool RunDeadStoreElimination(Function &F) {
+        MemoryLiveness liveness;
+        liveness.run(F);
+        // 先收集再删除: 删除store不会改变其他store之后的活跃性(store不gen), 一次求解就足够
+        std::vector<StoreInst *> dead_stores;
+        std::vector<AllocaInst *> slots;
+        for (Instruction &inst : instructions(F)) {
+            if (auto *store = dyn_cast<StoreInst>(&inst)) {
+                if (liveness.isDeadStore(*store)) {
+                    dead_stores.push_back(store);
+                }
+            } else if (auto *alloca = dyn_cast<AllocaInst>(&inst)) {
+                if (liveness.getSlot(alloca) == alloca) {
+                    slots.push_back(alloca);
+                }
+            }
+        }
+        liveness.release();
+
+        for (StoreInst *store : dead_stores) {
+            store->eraseFromParent();
+        }
+        unsigned num_slots = 0;
+        for (AllocaInst *alloca : slots) {
+            if (RemoveUnusedSlot(*alloca)) {
+                ++num_slots;
+            }
+        }
+        NumStoresRemoved += dead_stores.size();
+        NumSlotsRemoved += num_slots;
+        return !dead_stores.empty() || num_slots != 0;
+    }
+
+    PreservedAnalyses DeadStoreEliminationPass::run(Function &F, FunctionAnalysisManager &) {
+        if (!RunDeadStoreElimination(F)) {
+            return PreservedAnalyses::all();
+        }
+        PreservedAnalyses PA;
+        PA.preserveSet<CFGAnalyses>();
+        return PA;
+    }
+}
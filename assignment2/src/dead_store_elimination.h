@@ -0,0 +1,22 @@
+//
+// Created by sakura on 2026/10/17.
+//
+
+#ifndef ASSIGNMENT2_DEAD_STORE_ELIMINATION_H
+#define ASSIGNMENT2_DEAD_STORE_ELIMINATION_H
+
+#include <llvm/IR/Function.h>
+#include <llvm/IR/PassManager.h>
+
+namespace dfa {
+    /// @brief  对@p F 运行基于memory liveness的死存储消除: 删除写入不逃逸的alloca, 并且在被覆盖或函数返回之前
+    ///         不会被读取的store; 之后不再被读取的alloca连同它的lifetime intrinsic一起删除. 返回IR是否改变
+    bool RunDeadStoreElimination(llvm::Function &F);
+
+    /// New-PM Dead Store Elimination Pass
+    class DeadStoreEliminationPass : public llvm::PassInfoMixin<DeadStoreEliminationPass> {
+    public:
+        llvm::PreservedAnalyses run(llvm::Function &F, llvm::FunctionAnalysisManager &);
+    };
+}
+#endif //ASSIGNMENT2_DEAD_STORE_ELIMINATION_H
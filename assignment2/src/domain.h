@@ -0,0 +1,78 @@
+//
+// Created by sakura on 2026/10/17.
+//
+
+#ifndef ASSIGNMENT2_DOMAIN_H
+#define ASSIGNMENT2_DOMAIN_H
+
+#include <cassert>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace dfa {
+    /// Densely Indexed Domain
+    ///
+    /// 元素按照插入顺序从0开始编号，编号即该元素在bitvector中的位置。
+    /// _elements负责 编号->元素, _index负责 元素->编号, 两个方向都是O(1)。
+    ///
+    /// @tparam TDomainElement Domain Element, 需要提供operator==以及std::hash特化
+    template<class TDomainElement>
+    class Domain {
+    private:
+        std::vector<TDomainElement> _elements;
+        std::unordered_map<TDomainElement, unsigned> _index;
+    public:
+        typedef typename std::vector<TDomainElement>::const_iterator const_iterator;
+
+        /// @brief 插入@p elem , 若已经存在则不做任何事
+        /// @return @p elem 的编号
+        unsigned insert(const TDomainElement &elem) {
+            auto result = _index.emplace(elem, _elements.size());
+            if (result.second) {
+                _elements.push_back(elem);
+            }
+            return result.first->second;
+        }
+
+        /// @brief 原地构造一个元素并插入
+        template<class... TArgs>
+        unsigned emplace(TArgs &&... args) {
+            return insert(TDomainElement(std::forward<TArgs>(args)...));
+        }
+
+        /// @brief 找到@p elem 对应在bitvector的位置
+        /// @return 若@p elem 不在domain中则返回-1
+        int position(const TDomainElement &elem) const {
+            auto iter = _index.find(elem);
+            if (iter == _index.end()) {
+                return -1;
+            }
+            return iter->second;
+        }
+
+        bool contains(const TDomainElement &elem) const {
+            return _index.count(elem) != 0;
+        }
+
+        /// @brief 返回编号为@p idx 的元素
+        const TDomainElement &operator[](unsigned idx) const {
+            assert(idx < _elements.size() && "Domain index out of range.");
+            return _elements[idx];
+        }
+
+        unsigned size() const { return _elements.size(); }
+
+        bool empty() const { return _elements.empty(); }
+
+        void clear() {
+            _elements.clear();
+            _index.clear();
+        }
+
+        const_iterator begin() const { return _elements.begin(); }
+
+        const_iterator end() const { return _elements.end(); }
+    };
+}
+#endif //ASSIGNMENT2_DOMAIN_H
@@ -0,0 +1,103 @@
+//
+// Created by sakura on 2026/10/17.
+//
+
+// 并行求解的命令行选项, 以及模块级并行driver在旧pass manager下的注册:
+//   opt -load libAssignment2.so -liveness-parallel -dfa-threads=8 input.ll -o /dev/null
+//   opt -load libAssignment2.so -avail_expr-parallel input.ll -o /dev/null
+// 以及单个函数内的求解选项:
+//   opt -load libAssignment2.so -liveness -dfa-solver-threads=8 input.ll -o /dev/null
+//   opt -load libAssignment2.so -liveness -dfa-iteration=wto -dfa-print-evals input.ll -o /dev/null
+// 以及结果的输出格式:
+//   opt -load libAssignment2.so -liveness -dfa-output=jsonl -dfa-output-file=liveness.jsonl input.ll -o /dev/null
+//   opt -load libAssignment2.so -liveness-parallel -dfa-output=binary -dfa-output-file=liveness.bin input.ll -o /dev/null
+// 求解器的计数累加到LLVM Statistic中(见statistics.cpp), 各个阶段(domain init, IC fill, solve, dump)在-time-trace中计时:
+//   opt -load libAssignment2.so -liveness -stats -time-trace -time-trace-file=liveness.json input.ll -o /dev/null
+
+#include <memory>
+#include <string>
+
+#include <llvm/ADT/Twine.h>
+#include <llvm/Support/CommandLine.h>
+#include <llvm/Support/ErrorHandling.h>
+#include <llvm/Support/FileSystem.h>
+#include "avail_expr.h"
+#include "driver.h"
+#include "liveness.h"
+
+using namespace llvm;
+
+namespace {
+    cl::opt<unsigned> DFAThreads(
+            "dfa-threads", cl::init(0),
+            cl::desc("Number of threads used by the module-level dataflow driver (0 = all hardware threads)"));
+
+    cl::opt<unsigned> DFASolverThreads(
+            "dfa-solver-threads", cl::init(1),
+            cl::desc("Number of threads used to solve the SCCs of a single large function (0 = all hardware threads)"));
+
+    cl::opt<dfa::IterationStrategy> DFAIteration(
+            "dfa-iteration", cl::init(dfa::IterationStrategy::Worklist),
+            cl::desc("Iteration strategy of the sequential dataflow solver"),
+            cl::values(clEnumValN(dfa::IterationStrategy::Worklist, "worklist", "Worklist in traversal order"),
+                       clEnumValN(dfa::IterationStrategy::WTO, "wto",
+                                  "Weak topological order, stabilizing inner loops first")));
+
+    cl::opt<bool> DFAPrintEvals(
+            "dfa-print-evals", cl::init(false),
+            cl::desc("Report the number of transfer function evaluations of each function on stderr"));
+
+    cl::opt<dfa::OutputFormat> DFAOutput(
+            "dfa-output", cl::init(dfa::OutputFormat::Text),
+            cl::desc("Format of the dataflow results written by the printer passes"),
+            cl::values(clEnumValN(dfa::OutputFormat::Text, "text", "Every program point with its full set (default)"),
+                       clEnumValN(dfa::OutputFormat::Off, "off", "Solve only, write nothing"),
+                       clEnumValN(dfa::OutputFormat::Binary, "binary", "One bit-matrix record per function"),
+                       clEnumValN(dfa::OutputFormat::JSONL, "jsonl", "One JSON object per function and line")));
+
+    cl::opt<std::string> DFAOutputFile(
+            "dfa-output-file", cl::init("-"),
+            cl::desc("File the dataflow results are written to ('-' = the printer's stream, usually stdout)"));
+
+    RegisterPass<dfa::LegacyModulePrinterPass<dfa::Liveness>> X(
+            "liveness-parallel", "Liveness (parallel over the module)");
+    RegisterPass<dfa::LegacyModulePrinterPass<dfa::AvailExpr>> Y(
+            "avail_expr-parallel", "Available Expression (parallel over the module)");
+} // namespace anonymous
+
+namespace dfa {
+    unsigned ModuleThreads() {
+        return DFAThreads;
+    }
+
+    SolverOptions SolverOptionsFromCommandLine() {
+        SolverOptions options;
+        options.threads = DFASolverThreads;
+        options.strategy = DFAIteration;
+        return options;
+    }
+
+    bool PrintTransferEvaluations() {
+        return DFAPrintEvals;
+    }
+
+    OutputFormat OutputFormatFromCommandLine() {
+        return DFAOutput;
+    }
+
+    raw_ostream &ResultStream(raw_ostream &os) {
+        if (DFAOutputFile == "-") {
+            return os;
+        }
+        // 所有函数, 所有pass的结果依次追加到同一个文件, 进程退出时关闭
+        static std::unique_ptr<raw_fd_ostream> file;
+        if (file == nullptr) {
+            std::error_code error;
+            file.reset(new raw_fd_ostream(DFAOutputFile, error, sys::fs::OF_None));
+            if (error) {
+                report_fatal_error(Twine("cannot open ") + DFAOutputFile + ": " + error.message());
+            }
+        }
+        return *file;
+    }
+} // namespace dfa
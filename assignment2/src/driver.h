@@ -0,0 +1,174 @@
+//
+// Created by sakura on 2026/10/17.
+//
+
+#ifndef ASSIGNMENT2_DRIVER_H
+#define ASSIGNMENT2_DRIVER_H
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <llvm/ADT/DenseMap.h>
+#include <llvm/IR/Function.h>
+#include <llvm/IR/Module.h>
+#include <llvm/IR/PassManager.h>
+#include <llvm/Pass.h>
+#include <llvm/Support/ThreadPool.h>
+#include <llvm/Support/Threading.h>
+#include <llvm/Support/raw_ostream.h>
+#include "analysis.h"
+
+namespace dfa {
+    /// @brief 模块级driver使用的线程数, 由-dfa-threads指定, 0表示使用所有硬件线程
+    unsigned ModuleThreads();
+
+    /// @brief 模块级driver中每个任务的求解选项: 函数之间已经并行, 函数内部不再开线程池
+    inline SolverOptions ModuleTaskSolverOptions() {
+        SolverOptions options = SolverOptionsFromCommandLine();
+        options.threads = 1;
+        return options;
+    }
+
+    /// @brief  在线程池上对模块@p M 中每个有函数体的函数调用@p fn (func_idx, F) , 返回时所有调用都已完成.
+    ///         func_idx为函数在模块中(不含声明)的顺序, 调用方按它把结果放回固定的位置, 与调度顺序无关.
+    ///         函数按指令数从大到小提交, 最大的函数最先开始, 避免它最后才被调度而拖长整体时间.
+    ///         各个函数的分析互不依赖, @p fn 只能读取IR, 不能修改.
+    template<class TFn>
+    void ParallelForEachFunction(const llvm::Module &M, unsigned num_threads, TFn fn) {
+        std::vector<const llvm::Function *> functions;
+        for (const llvm::Function &F : M) {
+            if (F.isDeclaration()) {
+                continue;
+            }
+            // 参数列表是在第一次访问时才建立的, 先在主线程上访问一次, 之后工作线程只读
+            F.arg_begin();
+            functions.push_back(&F);
+        }
+        std::vector<unsigned> order(functions.size());
+        std::vector<unsigned> sizes(functions.size());
+        for (unsigned func_idx = 0; func_idx < functions.size(); ++func_idx) {
+            order[func_idx] = func_idx;
+            sizes[func_idx] = functions[func_idx]->getInstructionCount();
+        }
+        std::stable_sort(order.begin(), order.end(), [&](unsigned lhs, unsigned rhs) {
+            return sizes[lhs] > sizes[rhs];
+        });
+        // 只有一个线程(或只有一个函数)时直接在当前线程上执行
+        llvm::ThreadPoolStrategy strategy = llvm::hardware_concurrency(num_threads);
+        if (functions.size() <= 1 || strategy.compute_thread_count() <= 1) {
+            for (unsigned func_idx : order) {
+                fn(func_idx, *functions[func_idx]);
+            }
+            return;
+        }
+        llvm::ThreadPool pool(strategy);
+        for (unsigned func_idx : order) {
+            pool.async([&fn, &functions, func_idx] {
+                fn(func_idx, *functions[func_idx]);
+            });
+        }
+        pool.wait();
+    }
+
+    /// Module Driver
+    ///
+    /// 对整个模块并行地运行@p TAnalysis , 每个函数一个任务, 各自拥有独立的求解器(domain, arena和所有state),
+    /// 任务之间不共享任何可变状态. 结果按函数在模块中的顺序保存, 打印时也按该顺序拼接,
+    /// 所以输出与线程数和调度顺序无关, 与逐个函数运行旧pass的输出相同.
+    template<class TAnalysis>
+    class ModuleDriver {
+    private:
+        std::vector<std::unique_ptr<TAnalysis>> _results;
+        llvm::DenseMap<const llvm::Function *, unsigned> _index;
+    public:
+        /// @brief 求解@p M 中的所有函数, 结果一直保留到下一次run()
+        void run(const llvm::Module &M, unsigned num_threads = ModuleThreads()) {
+            _results.clear();
+            _index.clear();
+            for (const llvm::Function &F : M) {
+                if (!F.isDeclaration()) {
+                    _index[&F] = _results.size();
+                    _results.emplace_back();
+                }
+            }
+            SolverOptions options = ModuleTaskSolverOptions();
+            ParallelForEachFunction(M, num_threads, [this, &options](unsigned func_idx, const llvm::Function &F) {
+                std::unique_ptr<TAnalysis> analysis(new TAnalysis());
+                analysis->setOptions(options);
+                analysis->run(F);
+                _results[func_idx] = std::move(analysis);
+            });
+        }
+
+        /// @brief 函数@p F 的结果, @p F 没有函数体时返回nullptr
+        const TAnalysis *lookup(const llvm::Function &F) const {
+            auto iter = _index.find(&F);
+            return iter == _index.end() ? nullptr : _results[iter->second].get();
+        }
+
+        /// @brief  并行地求解并打印@p M 中的所有函数, 不保留结果:
+        ///         每个任务按-dfa-output的格式打印到自己的缓冲区后立即释放state, 最后按模块顺序写入@p os
+        static void print(const llvm::Module &M, llvm::raw_ostream &os, unsigned num_threads = ModuleThreads()) {
+            std::vector<std::string> outputs;
+            for (const llvm::Function &F : M) {
+                if (!F.isDeclaration()) {
+                    outputs.emplace_back();
+                }
+            }
+            SolverOptions options = ModuleTaskSolverOptions();
+            ParallelForEachFunction(M, num_threads, [&outputs, &options](unsigned func_idx, const llvm::Function &F) {
+                TAnalysis analysis;
+                analysis.setOptions(options);
+                analysis.run(F);
+                llvm::raw_string_ostream func_os(outputs[func_idx]);
+                PrintResults(analysis, F, func_os);
+                func_os.flush();
+            });
+            for (const std::string &output : outputs) {
+                os << output;
+            }
+        }
+    };
+
+    /// Legacy Module Printer Pass
+    ///
+    /// 旧pass manager下模块级的并行打印pass, 输出与LegacyPrinterPass相同.
+    template<class TAnalysis>
+    class LegacyModulePrinterPass final : public llvm::ModulePass {
+    public:
+        static char ID;
+
+        LegacyModulePrinterPass() : llvm::ModulePass(ID) {}
+
+        virtual ~LegacyModulePrinterPass() override {}
+
+        virtual void getAnalysisUsage(llvm::AnalysisUsage &AU) const override {
+            AU.setPreservesAll();
+        }
+
+        virtual bool runOnModule(llvm::Module &M) override {
+            ModuleDriver<TAnalysis>::print(M, ResultStream(llvm::outs()));
+            return false;
+        }
+    };
+
+    template<class TAnalysis>
+    char LegacyModulePrinterPass<TAnalysis>::ID = 0;
+
+    /// New-PM Module Printer Pass
+    template<class TAnalysis>
+    class ModulePrinterPass : public llvm::PassInfoMixin<ModulePrinterPass<TAnalysis>> {
+    private:
+        llvm::raw_ostream &_os;
+    public:
+        explicit ModulePrinterPass(llvm::raw_ostream &os) : _os(os) {}
+
+        llvm::PreservedAnalyses run(llvm::Module &M, llvm::ModuleAnalysisManager &) {
+            ModuleDriver<TAnalysis>::print(M, ResultStream(_os));
+            return llvm::PreservedAnalyses::all();
+        }
+    };
+}
+#endif //ASSIGNMENT2_DRIVER_H
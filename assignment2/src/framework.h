@@ -5,20 +5,32 @@
 #ifndef ASSIGNMENT2_FRAMEWORK_H
 #define ASSIGNMENT2_FRAMEWORK_H
 
+#include <atomic>
 #include <cassert>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
 #include <type_traits>
-#include <unordered_map>
 #include <unordered_set>
+#include <vector>
 
-#include <llvm/Pass.h>
-#include <llvm/ADT/BitVector.h>
+#include <llvm/ADT/DenseMap.h>
 #include <llvm/ADT/PostOrderIterator.h>
-#include <llvm/IR/CFG.h>
+#include <llvm/ADT/SmallVector.h>
 #include <llvm/IR/Function.h>
 #include <llvm/IR/InstIterator.h>
 #include <llvm/IR/Instructions.h>
+#include <llvm/Support/Allocator.h>
+#include <llvm/Support/ThreadPool.h>
+#include <llvm/Support/Threading.h>
+#include <llvm/Support/TimeProfiler.h>
 #include <llvm/Support/raw_ostream.h>
-#include "analysis_flag.h"
+#include "bitset.h"
+#include "sparse_bitset.h"
+#include "cfg.h"
+#include "domain.h"
+#include "output.h"
 using namespace llvm;
 namespace dfa {
     //analysis direction, 用作模板参数
@@ -26,12 +38,111 @@ namespace dfa {
         Forward, Backward
     };
 
+    /***********************************************************************
+     * Lattice (Meet Operator)
+     ***********************************************************************/
+    // 幂集格上的meet operator, 用作模板参数, 对集合的表示TSet需要提供:
+    //   Top(n):                 meet operation的单位元, 也是没有meet operand时的结果
+    //   Meet(result, operands): result <- operands[0] ∧ operands[1] ∧ ..., operands非空
+    //   MeetMasked(result, operands, kills):
+    //                           result <- (operands[0] - kills[0]) ∧ (operands[1] - kills[1]) ∧ ...
+    //   top_is_empty_c:         Top是否为空集, 即格中越往上元素越少(并集)还是越多(交集)
+
+    /// @brief 以并集为meet operation, 例如liveness
+    struct Union {
+        static constexpr bool top_is_empty_c = true;
+
+        template<class TSet>
+        static TSet Top(unsigned size) {
+            return TSet(size, false);
+        }
+
+        template<class TSet>
+        static void Meet(TSet &result, ArrayRef<const TSet *> operands) {
+            result.template assignMeet<kernel::OrOp>(operands);
+        }
+
+        template<class TSet>
+        static void MeetMasked(TSet &result, ArrayRef<const TSet *> operands, ArrayRef<const TSet *> kills) {
+            result.template assignMeetMasked<kernel::OrOp>(operands, kills);
+        }
+    };
+
+    /// @brief 以交集为meet operation, 例如available expressions
+    struct Intersection {
+        static constexpr bool top_is_empty_c = false;
+
+        template<class TSet>
+        static TSet Top(unsigned size) {
+            return TSet(size, true);
+        }
+
+        template<class TSet>
+        static void Meet(TSet &result, ArrayRef<const TSet *> operands) {
+            result.template assignMeet<kernel::AndOp>(operands);
+        }
+
+        template<class TSet>
+        static void MeetMasked(TSet &result, ArrayRef<const TSet *> operands, ArrayRef<const TSet *> kills) {
+            result.template assignMeetMasked<kernel::AndOp>(operands, kills);
+        }
+    };
+
+    /// @brief 求解器在基本块之间迭代的策略
+    enum class IterationStrategy {
+        //按遍历顺序初始化worklist, 结果改变时把dependents放回worklist
+        Worklist,
+        //按weak topological order求值, 内层循环先稳定再向外传播(Bourdoncle的recursive strategy)
+        WTO
+    };
+
+    /// @brief 求解器的选项, 不影响求解的结果, 只影响求解的方式
+    struct SolverOptions {
+        //单个函数内求解使用的线程数, 0表示使用所有硬件线程, 1表示顺序求解
+        unsigned threads = 1;
+        //顺序求解时的迭代策略, 并行求解时每个强连通分量内部总是使用worklist
+        IterationStrategy strategy = IterationStrategy::Worklist;
+    };
+
+    /// @brief 一次run()或update()中求解器的计数
+    struct SolverStatistics {
+        //迭代的轮数: worklist按遍历顺序绕回一次, 或者WTO中一个分量重新迭代一遍, 都算一轮
+        uint64_t iterations = 0;
+        //基本块级传递函数的求值次数
+        uint64_t transfers = 0;
+        //meet operation的次数, 位于边界的基本块直接取BC, 不算
+        uint64_t meets = 0;
+        unsigned domain_size = 0;
+        //求解结束时基本块和边上的state(gen/kill/bv/edge kill)占用的字节数
+        uint64_t state_bytes = 0;
+    };
+
+    /// @brief 把一次求解的@p stats 累加到LLVM Statistic(-stats)中
+    void RecordSolverStatistics(const SolverStatistics &stats);
+
     /// Dataflow Analysis Framework
     ///
+    /// 框架本身只是求解器, 不是pass: run()求解一个函数并保留结果, 之后可以通过BlockIn/BlockOut/InstIn/InstOut查询,
+    /// 直到下一次run()或release(). 旧pass manager下的打印pass以及新pass manager下的analysis见analysis.h.
+    ///
+    /// 子类通过CRTP把自己作为@p TDerived 传入, 框架在编译期直接调用子类的方法,
+    /// 求解器的内层循环中没有虚函数调用。子类需要提供(可以是protected, 但需要将框架声明为friend):
+    ///   set_t IC() const;
+    ///   set_t BC() const;
+    ///   void GenKill(const Instruction &inst, set_t &gen, set_t &kill) const;
+    ///   void InitializeDomainFromInstruction(const Instruction &inst);
+    /// 以及可选的 EdgeKill 和 ClearDomain.
+    ///
+    /// 集合的表示@p TSet 决定了每个程序点的state占用多少内存: 稠密的BitSet与domain大小成正比,
+    /// SparseBitSet只与集合中的元素个数成正比, AdaptiveBitSet根据密度在两者之间切换.
+    ///
+    /// @tparam TDerived       Concrete Analysis
     /// @tparam TDomainElement Domain Element
     /// @tparam TDirection     Direction of Analysis
-    template<class TDomainElement, Direction TDirection>
-    class Framework : public FunctionPass {
+    /// @tparam TMeetOp        Meet Operator, dfa::Union或dfa::Intersection
+    /// @tparam TSet           Set Representation, dfa::BitSet, dfa::SparseBitSet或dfa::AdaptiveBitSet
+    template<class TDerived, class TDomainElement, Direction TDirection, class TMeetOp, class TSet = BitSet>
+    class Framework {
 
         //    enable_if
         //    若B为true，则std::enable_if拥有等同于T的public成员typedef type；
@@ -60,256 +171,1027 @@ namespace dfa {
         using type_name = typename std::conditional<dir == TDirection, TrueTy, FalseTy>::type;
     protected:
         typedef TDomainElement domain_element_t;
+        typedef TMeetOp meet_op_t;
+        typedef TSet set_t;
+        typedef typename StateMatrix<TSet>::type matrix_t;
         static constexpr Direction direction_c = TDirection;
+
+        /// @brief 静态转换为子类, 所有的"虚"调用都经过这里
+        const TDerived &derived() const {
+            return static_cast<const TDerived &>(*this);
+        }
+
+        TDerived &derived() {
+            return static_cast<TDerived &>(*this);
+        }
+
         /***********************************************************************
         * Domain
         ***********************************************************************/
-        std::unordered_set<TDomainElement> _domain;
+        //元素按插入顺序稠密编号, 编号即其在bitvector中的位置
+        Domain<TDomainElement> _domain;
         /***********************************************************************
-         * Instruction-BitVector Mapping
+         * BasicBlock-BitSet Mapping
          ***********************************************************************/
-        //建立instruction pointer到BitVector的map
-        std::unordered_map<const Instruction *, BitVector> _inst_bv_map;
-
-        /// @biref 返回初始条件
-        /// @todo 在子类覆盖这个方法
-        virtual BitVector IC() const = 0;
+        //CFG快照, 基本块按遍历顺序稠密编号, 编号即其在下面各个state矩阵中的行号
+        CFGSnapshot _cfg;
+        //每个基本块的gen/kill摘要，在求解之前计算一次
+        matrix_t _bb_gen, _bb_kill;
+        //每个基本块"经过整个基本块的传递函数变换之后的state", 即沿着分析方向最后一条指令的state.
+        //求解器只在基本块边界上迭代。
+        matrix_t _bb_bv;
+        //每条meet operand边上的kill, 以边在_cfg中的编号为行号, 只有子类定义了EdgeKill时才分配
+        matrix_t _edge_kill;
+        /***********************************************************************
+         * Instruction-BitSet Mapping
+         ***********************************************************************/
+        //指令的编号即其在_cfg中的编号, 只在第一次通过InstBV查询时才建立索引并分配矩阵,
+        //_materialized记录哪些基本块的指令state已经重建
+        mutable DenseMap<const Instruction *, unsigned> _inst_idx;
+        mutable matrix_t _inst_bv;
+        mutable BitSet _materialized;
 
-        /// @biref 返回边界条件
-        /// @todo 在子类覆盖这个方法
-        virtual BitVector BC() const = 0;
+    private:
+        //稠密表示的state矩阵都从这里分配, 在runOnFunction结束时一次性释放
+        mutable BumpPtrAllocator _arena;
+        //transferBlock中存放meet结果的临时集合
+        set_t _input_scratch;
+        SolverOptions _options;
+        //自上一次run()或update()以来IR被修改过的基本块, 以及修改是否可能改变CFG或domain
+        BitSet _dirty;
+        bool _cfg_dirty = false, _domain_dirty = false;
+        //上一次run()或update()的计数
+        SolverStatistics _stats;
+        //基本块少于这个数时并行求解得不偿失, 总是顺序求解
+        static constexpr unsigned ParallelSolveMinBlocks = 1024;
 
     private:
         /// @biref
         /// Dump the domain under @p mask .
         /// If @c domain = {%1, %2, %3,}, dumping it with @p mask = 001 will give {%3,}
-        void printDomainWithMask(const BitVector &mask) const {
-            outs() << "{";
+        void printDomainWithMask(const set_t &mask, raw_ostream &os) const {
+            os << "{";
             assert(mask.size() == _domain.size() && "The size of mask must be equal to the size of domain.");
-            unsigned mask_idx = 0;
-            // 若代表domain对应节点的mask bit不为0，则打印，否则跳过。
-            for (const auto &elem : _domain) {
-                assert(mask_idx >= 0 && mask_idx < mask.size());
-                if (!mask[mask_idx++]) {
-                    continue;
-                }
-                outs() << elem << ",";
-            }// for (mask_idx ∈ [0, mask.size()))
-            outs() << "}";
+            // 只打印mask bit不为0的位置所对应的domain元素
+            for (unsigned mask_idx : mask.set_bits()) {
+                os << _domain[mask_idx] << ",";
+            }
+            os << "}";
         }
 
-        METHOD_ENABLE_IF_DIRECTION(Direction::Forward, void)
-        printInstBV(const Instruction &inst) const {
+        void printInstBV(const Instruction &inst, const set_t &inst_bv, raw_ostream &os) const {
             const BasicBlock *const pbb = inst.getParent();
             if (&inst == &(*pbb->begin())) {
-                meetop_const_range meet_operands = MeetOperands(*pbb);
-                // 如果前驱节点为空，则我们位于边界，打印出BC
-                if (meet_operands.empty()) {
-                    outs() << "BC:\t";
-                    printDomainWithMask(BC());
-                    outs() << "\n";
+                // 如果meet operand为空，则我们位于边界，打印出BC
+                unsigned bb_idx = _cfg.index(*pbb);
+                if (IsBoundary(bb_idx)) {
+                    os << "BC:\t";
                 } else {
-                    outs() << "MeetOp:\t";
-                    printDomainWithMask(MeetOp(meet_operands));
-                    outs() << "\n";
+                    os << "MeetOp:\t";
                 }
+                printDomainWithMask(BlockInput(bb_idx), os);
+                os << "\n";
             }
-            outs() << "Instruction: " << inst << "\n";
-            outs() << "\t";
-            printDomainWithMask(_inst_bv_map.at(&inst));
-            outs() << "\n";
+            os << "Instruction: " << inst << "\n";
+            os << "\t";
+            printDomainWithMask(inst_bv, os);
+            os << "\n";
         }
 
-        METHOD_ENABLE_IF_DIRECTION(Direction::Backward, void)
-        printInstBV(const Instruction &inst) const {
-            const BasicBlock *const pbb = inst.getParent();
-
-            if (&inst == &(*pbb->begin())) {
-                meetop_const_range meet_operands = MeetOperands(*pbb);
-                //如果后继节点为空，则我们位于边界，打印出BC
-                if (meet_operands.empty()) {
-                    outs() << "BC:\t";
-                    printDomainWithMask(BC());
-                    outs() << "\n";
-                } else {
-                    outs() << "MeetOp:\t";
-#ifndef LA
-                    printDomainWithMask(MeetOp(meet_operands));
-#else
-                    printDomainWithMask(MeetOp(*pbb));
-#endif
-                    outs() << "\n";
+        /// @brief  按布局顺序对@p F 的每个基本块调用@p fn (bb, bb_idx, inst_bvs), @p inst_bvs 为重建出的
+        ///         该基本块内每条指令的state, 用完即丢弃, 各基本块复用同一组集合
+        template<class TFn>
+        void forEachMaterializedBlock(const Function &F, TFn fn) const {
+            std::vector<set_t> inst_bvs;
+            for (const auto &bb : F) {
+                unsigned bb_size = bb.size();
+                if (inst_bvs.size() < bb_size) {
+                    inst_bvs.resize(bb_size);
                 }
+                unsigned bb_idx = _cfg.index(bb);
+                MutableArrayRef<set_t> block_bvs(inst_bvs.data(), bb_size);
+                materializeBlock(bb_idx, block_bvs);
+                fn(bb, bb_idx, ArrayRef<set_t>(block_bvs));
             }
-            outs() << "Instruction: " << inst << "\n";
-            outs() << "\t";
-            printDomainWithMask(_inst_bv_map.at(&inst));
-            outs() << "\n";
         }
 
-    protected:
-        /// @brief Dump, ∀inst ∈ @p F, the associated bitvector.
-        void printInstBVMap(const Function &F) const {
-            outs() << "********************************************" << "\n";
-            outs() << "* Instruction-BitVector Mapping             " << "\n";
-            outs() << "********************************************" << "\n";
+        /// @brief 把@p bv 按64位的word写成二进制的一行, 共@p num_words 个word
+        static void writeBinaryRow(const set_t &bv, unsigned num_words, std::vector<uint64_t> &words,
+                                   ResultWriter &writer) {
+            words.assign(num_words, 0);
+            for (unsigned idx : bv.set_bits()) {
+                words[idx / 64] |= uint64_t(1) << (idx % 64);
+            }
+            for (uint64_t word : words) {
+                writer.writeU64(word);
+            }
+        }
 
-            for (const auto &inst : instructions(F)) {
-                printInstBV(inst);
+    public:
+        /// @brief Dump, ∀inst ∈ @p F, the associated bitvector. 要求@p F 已经run()过
+        void printInstBVMap(const Function &F, raw_ostream &os) const {
+            os << "********************************************" << "\n";
+            os << "* Instruction-BitVector Mapping             " << "\n";
+            os << "********************************************" << "\n";
+
+            forEachMaterializedBlock(F, [&](const BasicBlock &bb, unsigned, ArrayRef<set_t> inst_bvs) {
+                unsigned inst_idx = 0;
+                for (const auto &inst : bb) {
+                    printInstBV(inst, inst_bvs[inst_idx++], os);
+                }
+            });
+        }
+
+        /// @brief  以结构化的@p format (Binary或JSONL)写出与printInstBVMap相同的内容. domain元素只格式化一次,
+        ///         之后每个集合只写元素的编号. 要求@p F 已经run()过. 按布局顺序, 每个基本块先写meet的结果
+        ///         (即printInstBVMap中的MeetOp/BC), 再写每条指令的state.
+        ///
+        ///         Binary, 每个函数一条记录, 整数为little endian, 字符串为u32的字节数加内容:
+        ///           "DFA1", 函数名, u32 domain大小, 每个domain元素的字符串,
+        ///           u32 基本块数, 每个基本块: u32 指令数, (1 + 指令数)行bit matrix,
+        ///           每行ceil(domain大小 / 64)个u64, 第i位表示编号为i的元素
+        ///         JSONL, 每个函数一行:
+        ///           {"function":..., "domain":[...], "blocks":[{"input":[编号...], "insts":[[编号...], ...]}, ...]}
+        void writeResults(const Function &F, OutputFormat format, ResultWriter &writer) const {
+            if (format == OutputFormat::Binary) {
+                writer.write("DFA1");
+                writer.writeBytes(F.getName());
+                writer.writeU32(_domain.size());
+                for (unsigned elem_idx = 0; elem_idx < _domain.size(); ++elem_idx) {
+                    writer.writeBytes(ToString(_domain[elem_idx]));
+                }
+                writer.writeU32(F.size());
+                unsigned num_words = (_domain.size() + 63) / 64;
+                std::vector<uint64_t> words;
+                forEachMaterializedBlock(F, [&](const BasicBlock &, unsigned bb_idx, ArrayRef<set_t> inst_bvs) {
+                    writer.writeU32(inst_bvs.size());
+                    writeBinaryRow(BlockInput(bb_idx), num_words, words, writer);
+                    for (const set_t &inst_bv : inst_bvs) {
+                        writeBinaryRow(inst_bv, num_words, words, writer);
+                    }
+                });
+                return;
+            }
+            assert(format == OutputFormat::JSONL && "Only Binary and JSONL are structured formats.");
+            writer.write("{\"function\":");
+            writer.writeJSONString(F.getName());
+            writer.write(",\"domain\":[");
+            for (unsigned elem_idx = 0; elem_idx < _domain.size(); ++elem_idx) {
+                if (elem_idx != 0) {
+                    writer.write(',');
+                }
+                writer.writeJSONString(ToString(_domain[elem_idx]));
             }
+            writer.write("],\"blocks\":[");
+            bool first_bb = true;
+            forEachMaterializedBlock(F, [&](const BasicBlock &, unsigned bb_idx, ArrayRef<set_t> inst_bvs) {
+                writer.write(first_bb ? "{\"input\":" : ",{\"input\":");
+                first_bb = false;
+                writer.writeJSONArray(BlockInput(bb_idx).set_bits());
+                writer.write(",\"insts\":[");
+                for (unsigned inst_idx = 0; inst_idx < inst_bvs.size(); ++inst_idx) {
+                    if (inst_idx != 0) {
+                        writer.write(',');
+                    }
+                    writer.writeJSONArray(inst_bvs[inst_idx].set_bits());
+                }
+                writer.write("]}");
+            });
+            writer.write("]}\n");
         }
+
+    protected:
         /***********************************************************************
          * Meet Operator and Transfer Function
          ***********************************************************************/
-        /// @brief 如果是前向分析，则meetop_const_range定义为pred，否则为succ。
-        TYPEDEF_IF_DIRECTION(meetop_const_range, Direction::Forward, pred_const_range, succ_const_range);
+        /// @brief 返回编号为@p bb_idx 的基本块的所有前驱的编号, 即Meet operation的操作数(operands)
+        METHOD_ENABLE_IF_DIRECTION(Direction::Forward, ArrayRef<unsigned>)
+        MeetOperands(unsigned bb_idx) const {
+            return _cfg.preds(bb_idx);
+        }
 
-        /// @brief 返回一个可以遍历所有前向节点的迭代器range, 即返回Meet operation的操作数(operands)
-        METHOD_ENABLE_IF_DIRECTION(Direction::Forward, meetop_const_range)
-        MeetOperands(const BasicBlock &bb) const {
-            return predecessors(&bb);
+        /// @brief 返回编号为@p bb_idx 的基本块的所有后继的编号
+        METHOD_ENABLE_IF_DIRECTION(Direction::Backward, ArrayRef<unsigned>)
+        MeetOperands(unsigned bb_idx) const {
+            return _cfg.succs(bb_idx);
         }
 
-        /// @brief 返回一个可以遍历所有后继节点的迭代器range
-        METHOD_ENABLE_IF_DIRECTION(Direction::Backward, meetop_const_range)
-        MeetOperands(const BasicBlock &bb) const {
-            return successors(&bb);
+        /// @brief 编号为@p bb_idx 的基本块的第一条meet operand边的编号, 第k个meet operand即第k条边
+        METHOD_ENABLE_IF_DIRECTION(Direction::Forward, unsigned)
+        MeetEdgeBegin(unsigned bb_idx) const {
+            return _cfg.predBegin(bb_idx);
         }
 
-        /// @brief  在所有meet_operands上执行meet operation.
-        /// @return 执行完meet operation之后的result bitVector.
-        /// @todo   在每个子类的方法里覆盖这个方法
-        virtual BitVector MeetOp(const meetop_const_range &meet_operands) const = 0;
+        METHOD_ENABLE_IF_DIRECTION(Direction::Backward, unsigned)
+        MeetEdgeBegin(unsigned bb_idx) const {
+            return _cfg.succBegin(bb_idx);
+        }
 
-        /// @brief  在所有meet_operands上执行meet operation.
-        /// @return 执行完meet operation之后的result bitVector.
-        /// @todo   在每个子类的方法里覆盖这个方法
-        virtual BitVector MeetOp(const BasicBlock &bb) const = 0;
+        /// @brief  计算CFG边(@p from -> @p to, 方向与分析方向一致)上的传递函数 f(x) = x - kill, 写入@p kill .
+        ///         每条边只在求解之前计算一次, meet时每个operand只多一次AND-NOT.
+        ///         默认不做任何事, 子类可以定义同名方法来覆盖(例如liveness对phi的处理).
+        void EdgeKill(const BasicBlock &from, const BasicBlock &to, set_t &kill) const {}
 
+    private:
+        /// @brief 子类是否定义了自己的EdgeKill, 没有的话meet时不需要读取边上的kill
+        static constexpr bool HasEdgeKill() {
+            return !std::is_same<decltype(&TDerived::EdgeKill), decltype(&Framework::EdgeKill)>::value;
+        }
 
-        /// @brief  将指令@p inst的传递函数应用于传入的input bitvector，以获取output bitvector
-        /// @return 如果@p obv改变则返回true, 否则返回false.
-        /// @todo   在每个子类的方法里覆盖这个方法
+        /// @brief 为每条meet operand边预先计算kill
+        void summarizeEdges() {
+            if (!HasEdgeKill()) {
+                return;
+            }
+            _edge_kill.allocate(_arena, _cfg.numEdges(), _domain.size());
+            for (unsigned bb_idx = 0; bb_idx < _cfg.size(); ++bb_idx) {
+                unsigned edge_idx = MeetEdgeBegin(bb_idx);
+                for (unsigned op_idx : MeetOperands(bb_idx)) {
+                    derived().EdgeKill(*_cfg.block(op_idx), *_cfg.block(bb_idx), _edge_kill[edge_idx++]);
+                }
+            }
+        }
+
+    protected:
+        /// @brief  在编号为@p bb_idx 的基本块的所有meet operands上执行meet operation, 结果写入@p result .
+        ///         所有operand(以及各条边上的kill)一次性交给TMeetOp, 只扫描一遍word数组.
+        void MeetOp(unsigned bb_idx, set_t &result) const {
+            ArrayRef<unsigned> meet_operands = MeetOperands(bb_idx);
+            if (meet_operands.empty()) {
+                result = TMeetOp::template Top<TSet>(_domain.size());
+                return;
+            }
+            SmallVector<const set_t *, 4> operands;
+            for (unsigned op_idx : meet_operands) {
+                operands.push_back(&_bb_bv[op_idx]);
+            }
+            result.resize(_domain.size());
+            if (HasEdgeKill()) {
+                SmallVector<const set_t *, 4> kills;
+                unsigned edge_idx = MeetEdgeBegin(bb_idx);
+                for (unsigned k = 0; k < meet_operands.size(); ++k) {
+                    kills.push_back(&_edge_kill[edge_idx + k]);
+                }
+                TMeetOp::template MeetMasked<TSet>(result, operands, kills);
+            } else {
+                TMeetOp::template Meet<TSet>(result, operands);
+            }
+        }
 
-        virtual bool TransferFunc(const Instruction &inst,
-                                  const BitVector &ibv,
-                                  BitVector &obv) = 0;
+        /// @brief  将传递函数 f(x) = (x - kill) ∪ gen 应用于传入的input bitvector，以获取output bitvector.
+        ///         写回与比较在同一个循环里完成, @p ibv 与@p obv 可以是同一个对象.
+        /// @return 如果@p obv改变则返回true, 否则返回false.
+        bool TransferFunc(const set_t &ibv,
+                          const set_t &gen,
+                          const set_t &kill,
+                          set_t &obv) const {
+            return obv.assignTransfer(ibv, gen, kill);
+        }
 
         /***********************************************************************
          * CFG Traversal
          ***********************************************************************/
     private:
-        /// @brief 如果@p dir是Forward，则bb_traversal_const_range为const_iterator range，否则为const_reverse_iterator range
-        TYPEDEF_IF_DIRECTION(bb_traversal_const_range, Direction::Forward,
-                             iterator_range<Function::const_iterator>,
-                             iterator_range<Function::BasicBlockListType::const_reverse_iterator>);
-
-        /// @brief 如果@p dir是Forward，则inst_traversal_const_range为const_iterator range，否则为const_reverse_iterator range
+        /// @brief 如果@p dir是Forward，则inst_traversal_const_range为正序的指令range，否则为逆序的指令range
         TYPEDEF_IF_DIRECTION(inst_traversal_const_range, Direction::Forward,
-                             iterator_range<BasicBlock::const_iterator>,
-                             iterator_range<BasicBlock::InstListType::const_reverse_iterator>);
+                             ArrayRef<const Instruction *>,
+                             iterator_range<ArrayRef<const Instruction *>::reverse_iterator>);
 
+        /// @brief 返回依赖于编号为@p bb_idx 的基本块的结果的基本块，前向分析为后继，后向分析为前驱
+        METHOD_ENABLE_IF_DIRECTION(Direction::Forward, ArrayRef<unsigned>)
+        Dependents(unsigned bb_idx) const {
+            return _cfg.succs(bb_idx);
+        }
+
+        METHOD_ENABLE_IF_DIRECTION(Direction::Backward, ArrayRef<unsigned>)
+        Dependents(unsigned bb_idx) const {
+            return _cfg.preds(bb_idx);
+        }
+
+        /// @brief 判断编号为@p bb_idx 的基本块是否位于边界, 即没有meet operand:
+        ///        前向分析为entry(以及不可达的无前驱基本块), 后向分析为没有后继的基本块。
+        bool IsBoundary(unsigned bb_idx) const {
+            return MeetOperands(bb_idx).empty();
+        }
 
         /// @brief Return the traversal order of the basic blocks.
-        METHOD_ENABLE_IF_DIRECTION(Direction::Forward, bb_traversal_const_range)
+        ///        前向分析使用reverse post-order, 后向分析使用post-order,
+        ///        从entry不可达的基本块按布局顺序追加在最后。
+        METHOD_ENABLE_IF_DIRECTION(Direction::Forward, std::vector<const BasicBlock *>)
         BBTraversalOrder(const Function &F) const {
-            return make_range(F.begin(), F.end());
+            ReversePostOrderTraversal<const Function *> rpot(&F);
+            std::vector<const BasicBlock *> order(rpot.begin(), rpot.end());
+            appendUnreachable(F, order);
+            return order;
         }
 
-        METHOD_ENABLE_IF_DIRECTION(Direction::Backward, bb_traversal_const_range)
+        METHOD_ENABLE_IF_DIRECTION(Direction::Backward, std::vector<const BasicBlock *>)
         BBTraversalOrder(const Function &F) const {
-            return make_range(F.getBasicBlockList().rbegin(), F.getBasicBlockList().rend());
+            std::vector<const BasicBlock *> order(po_begin(&F), po_end(&F));
+            appendUnreachable(F, order);
+            return order;
         }
 
-        /// @brief Return the traversal order of the instructions.
+        void appendUnreachable(const Function &F, std::vector<const BasicBlock *> &order) const {
+            if (order.size() == F.size()) {
+                return;
+            }
+            std::unordered_set<const BasicBlock *> visited(order.begin(), order.end());
+            for (const BasicBlock &bb : F) {
+                if (!visited.count(&bb)) {
+                    order.push_back(&bb);
+                }
+            }
+        }
+
+        /// @brief Return the traversal order of the instructions in the basic block numbered @p bb_idx .
         METHOD_ENABLE_IF_DIRECTION(Direction::Forward, inst_traversal_const_range)
-        InstTraversalOrder(const BasicBlock &bb) const {
-            return make_range(bb.begin(), bb.end());
+        InstTraversalOrder(unsigned bb_idx) const {
+            return _cfg.insts(bb_idx);
         }
 
         METHOD_ENABLE_IF_DIRECTION(Direction::Backward, inst_traversal_const_range)
-        InstTraversalOrder(const BasicBlock &bb) const {
-            return make_range(bb.getInstList().rbegin(), bb.getInstList().rend());
+        InstTraversalOrder(unsigned bb_idx) const {
+            return reverse(_cfg.insts(bb_idx));
         }
 
     protected:
-        /// @brief 找到_domain中的elem对应在bitvector的位置
+        /// @brief 找到_domain中的elem对应在bitvector的位置, 不存在则返回-1
         int position(const TDomainElement &elem) const {
-            auto elem_iter = _domain.find(elem);
-            if (elem_iter == _domain.end()) {
-//                assert(elem_iter == _domain.end());
-                return -1;
-            } else {
-                int pos = 0;
-                //顺序遍历domain，以找到elem在domain中对应的位置
-                for (auto domain_iter = _domain.begin(); domain_iter != elem_iter; domain_iter++, pos++) {}
-                return pos;
-            }
-        }
-
-        /// @brief  遍历CFG图并更新@c inst_bv_map .
-        /// @return 如果@c inst_bv_map被改变则返回true, 否则返回false
-        /// @todo   实现这个方法为所有子类
-        bool traverseCFG(const Function &func) {
-            bool changed = false;
-            //获取entry basic block的地址
-            const BasicBlock *entry = &*(BBTraversalOrder(func).begin());
-            BitVector initialBV, inputBV;
-            for (auto &bb : BBTraversalOrder(func)) {
-                if (entry == &bb) {
-                    // initialBV <- Boundary Condition
-                    initialBV = BC();
+            return _domain.position(elem);
+        }
+
+        /// @brief 返回基本块@p bb 的稠密编号
+        unsigned BlockIdx(const BasicBlock &bb) const {
+            return _cfg.index(bb);
+        }
+
+        /// @brief 返回基本块@p bb 经过传递函数之后的state
+        const set_t &BlockBV(const BasicBlock &bb) const {
+            return _bb_bv[BlockIdx(bb)];
+        }
+
+        /// @brief  计算指令@p inst 的gen/kill, 并将gen规范化为 gen - kill,
+        ///         使得 (x ∪ gen) - kill == (x - kill) ∪ gen.
+        void InstGenKill(const Instruction &inst, set_t &gen, set_t &kill) const {
+            gen.resize(_domain.size());
+            gen.reset();
+            kill.resize(_domain.size());
+            kill.reset();
+            derived().GenKill(inst, gen, kill);
+            gen.reset(kill);
+        }
+
+        /// @brief  沿着分析方向合并基本块@p bb 内所有指令的gen/kill, 得到整个基本块的传递函数.
+        ///         f2(f1(x)) = (x - (kill1 ∪ kill2)) ∪ ((gen1 - kill2) ∪ gen2)
+        void summarizeBlock(unsigned bb_idx) {
+            set_t &bb_gen = _bb_gen[bb_idx], &bb_kill = _bb_kill[bb_idx];
+            set_t gen, kill;
+            for (const Instruction *inst : InstTraversalOrder(bb_idx)) {
+                InstGenKill(*inst, gen, kill);
+                bb_gen.reset(kill);
+                bb_gen |= gen;
+                bb_kill |= kill;
+            }
+        }
+
+        /// @brief  计算编号为@p bb_idx 的基本块沿分析方向的输入state并写入@p input ,
+        ///         边界处为BC, 否则为meet operation的结果
+        void BlockInput(unsigned bb_idx, set_t &input) const {
+            if (IsBoundary(bb_idx)) {
+                // initialBV <- Boundary Condition
+                input = derived().BC();
+                return;
+            }
+            // initialB <- MeetOp(MeetOperands(bb));
+            MeetOp(bb_idx, input);
+        }
+
+        set_t BlockInput(unsigned bb_idx) const {
+            set_t input;
+            BlockInput(bb_idx, input);
+            return input;
+        }
+
+        /// @brief  对编号为@p bb_idx 的基本块应用其gen/kill摘要, 并更新@c bb_bv .
+        /// @return 如果该基本块的bitvector被改变则返回true, 否则返回false
+        bool transferBlock(unsigned bb_idx) {
+            // 复用同一个集合存放meet的结果, 避免每次都分配
+            return transferBlock(bb_idx, _input_scratch);
+        }
+
+        /// @brief 同上, 但meet的结果存放在调用方提供的@p input 中, 供多个线程同时调用
+        bool transferBlock(unsigned bb_idx, set_t &input) {
+            BlockInput(bb_idx, input);
+            return TransferFunc(input, _bb_gen[bb_idx], _bb_kill[bb_idx], _bb_bv[bb_idx]);
+        }
+
+        /// @brief  记录一次编号为@p bb_idx 的基本块的求值, @p order 为它在本次迭代顺序中的位置.
+        ///         位置不大于上一次求值的位置@p last_order 时说明又回到了前面, 开始新的一轮
+        void countTransfer(unsigned bb_idx, unsigned order, unsigned &last_order, SolverStatistics &stats) const {
+            if (order <= last_order) {
+                ++stats.iterations;
+            }
+            last_order = order;
+            ++stats.transfers;
+            if (!IsBoundary(bb_idx)) {
+                ++stats.meets;
+            }
+        }
+
+        /// @brief  从基本块的输入state出发，逐条指令重建编号为@p bb_idx 的基本块内每条指令的state,
+        ///         按指令在基本块中的布局顺序写入@p inst_bvs .
+        void materializeBlock(unsigned bb_idx, MutableArrayRef<set_t> inst_bvs) const {
+            assert(inst_bvs.size() == _cfg.insts(bb_idx).size());
+            set_t bv = BlockInput(bb_idx), gen, kill;
+            unsigned inst_idx = 0;
+            for (const Instruction *inst : InstTraversalOrder(bb_idx)) {
+                InstGenKill(*inst, gen, kill);
+                TransferFunc(bv, gen, kill, bv);
+                //后向分析时逆序遍历指令，所以要倒着放回去
+                unsigned pos = direction_c == Direction::Forward ? inst_idx : inst_bvs.size() - 1 - inst_idx;
+                inst_bvs[pos] = bv;
+                ++inst_idx;
+            }
+        }
+
+        /// @brief  用worklist求解数据流方程, 直到@c bb_bv 达到不动点.
+        ///         只有当某个基本块的结果改变时，才把依赖它的基本块重新放回worklist.
+        void solve() {
+            solve(BitSet(_cfg.size(), true));
+        }
+
+        /// @brief  同上, 但worklist中一开始只有@p seeds 中的基本块, 其余基本块要求已经满足方程
+        void solve(BitSet seeds) {
+            // 基本块的编号就是遍历顺序, 按编号初始化worklist, in_worklist标记基本块当前是否已在worklist中
+            std::deque<unsigned> worklist;
+            for (unsigned bb_idx : seeds.set_bits()) {
+                worklist.push_back(bb_idx);
+            }
+            BitSet &in_worklist = seeds;
+            unsigned last_idx = ~0u;
+            while (!worklist.empty()) {
+                unsigned bb_idx = worklist.front();
+                worklist.pop_front();
+                in_worklist.reset(bb_idx);
+                countTransfer(bb_idx, bb_idx, last_idx, _stats);
+                if (!transferBlock(bb_idx)) {
+                    continue;
+                }
+                for (unsigned dep_idx : Dependents(bb_idx)) {
+                    if (!in_worklist.test(dep_idx)) {
+                        in_worklist.set(dep_idx);
+                        worklist.push_back(dep_idx);
+                    }
+                }
+            }
+        }
+
+        /// @brief  在强连通分量@p scc 内部用worklist迭代到不动点, 要求它依赖的分量都已经求解完毕.
+        ///         只读取其他分量的state, 只写入本分量的state, 不同的分量可以在不同的线程上同时求解.
+        /// @param in_worklist 以基本块编号为下标, 每个基本块占一个字节, 不同分量之间不会写到同一个位置
+        void solveComponent(const SCCPartition &sccs, unsigned scc, set_t &input, std::deque<unsigned> &worklist,
+                            std::vector<unsigned char> &in_worklist, SolverStatistics &stats) {
+            for (unsigned bb_idx : sccs.members(scc)) {
+                worklist.push_back(bb_idx);
+                in_worklist[bb_idx] = true;
+            }
+            unsigned last_idx = ~0u;
+            while (!worklist.empty()) {
+                unsigned bb_idx = worklist.front();
+                worklist.pop_front();
+                in_worklist[bb_idx] = false;
+                countTransfer(bb_idx, bb_idx, last_idx, stats);
+                if (!transferBlock(bb_idx, input)) {
+                    continue;
+                }
+                // 其他分量中的dependent还没有开始求解, 轮到它们时会从头处理, 这里只需要关心本分量
+                for (unsigned dep_idx : Dependents(bb_idx)) {
+                    if (sccs.sccOf(dep_idx) == scc && !in_worklist[dep_idx]) {
+                        in_worklist[dep_idx] = true;
+                        worklist.push_back(dep_idx);
+                    }
+                }
+            }
+        }
+
+        /// @brief  把CFG划分为强连通分量, 沿着分量构成的DAG在线程池上并行求解:
+        ///         一个分量的所有DAG前驱都求解完毕之后它才变为就绪, 互不依赖的分量同时求解, 每个分量内部迭代到不动点.
+        ///         数据流方程从同样的初值(IC)出发, 不动点与求值顺序无关, 所以结果与solve()完全相同.
+        void solveParallel(ThreadPoolStrategy strategy) {
+            SCCPartition sccs;
+            sccs.build(_cfg, direction_c == Direction::Forward);
+            if (sccs.size() <= 1) {
+                solve();
+                return;
+            }
+            // pending[scc]为分量scc还没有求解完毕的DAG前驱的个数, 减到0的线程负责调度它
+            std::unique_ptr<std::atomic<unsigned>[]> pending(new std::atomic<unsigned>[sccs.size()]);
+            for (unsigned scc = 0; scc < sccs.size(); ++scc) {
+                pending[scc].store(sccs.numDAGPreds(scc), std::memory_order_relaxed);
+            }
+            std::vector<unsigned char> in_worklist(_cfg.size(), false);
+            std::atomic<uint64_t> iterations(0), transfers(0), meets(0);
+            ThreadPool pool(strategy);
+            // 每个任务沿着DAG往下求解一条链: 求解完一个分量后, 继续求解其第一个变为就绪的后继,
+            // 其余就绪的后继作为新任务提交, 这样只有在真正出现分叉时才需要经过线程池
+            std::function<void(unsigned)> solve_chain = [&](unsigned scc) {
+                set_t input;
+                std::deque<unsigned> worklist;
+                SolverStatistics chain_stats;
+                const unsigned none = ~0u;
+                while (scc != none) {
+                    solveComponent(sccs, scc, input, worklist, in_worklist, chain_stats);
+                    unsigned next = none;
+                    for (unsigned succ_scc : sccs.dagSuccs(scc)) {
+                        if (pending[succ_scc].fetch_sub(1, std::memory_order_acq_rel) != 1) {
+                            continue;
+                        }
+                        if (next == none) {
+                            next = succ_scc;
+                        } else {
+                            pool.async([&solve_chain, succ_scc] { solve_chain(succ_scc); });
+                        }
+                    }
+                    scc = next;
+                }
+                iterations.fetch_add(chain_stats.iterations, std::memory_order_relaxed);
+                transfers.fetch_add(chain_stats.transfers, std::memory_order_relaxed);
+                meets.fetch_add(chain_stats.meets, std::memory_order_relaxed);
+            };
+            for (unsigned scc = 0; scc < sccs.size(); ++scc) {
+                if (sccs.numDAGPreds(scc) == 0) {
+                    pool.async([&solve_chain, scc] { solve_chain(scc); });
+                }
+            }
+            pool.wait();
+            _stats.iterations += iterations.load(std::memory_order_relaxed);
+            _stats.transfers += transfers.load(std::memory_order_relaxed);
+            _stats.meets += meets.load(std::memory_order_relaxed);
+        }
+
+        /// @brief  按weak topological order求解(Bourdoncle的recursive strategy): 顺序求值WTO中的基本块,
+        ///         到达一个分量的末尾时重新求值它的head, head的结果不再改变说明整个分量已经稳定, 否则再迭代一遍分量内部.
+        ///         嵌套的分量用显式的栈代替递归, 内层分量稳定之后才回到外层.
+        void solveWTO() {
+            WeakTopologicalOrder wto;
+            wto.build(_cfg, direction_c == Direction::Forward);
+            //当前所在的各层分量: (head的位置, 分量的结束位置)
+            std::vector<std::pair<unsigned, unsigned>> components;
+            unsigned pos = 0, last_pos = ~0u;
+            while (true) {
+                unsigned end = components.empty() ? wto.size() : components.back().second;
+                if (pos < end) {
+                    countTransfer(wto[pos], pos, last_pos, _stats);
+                    transferBlock(wto[pos]);
+                    if (wto.isHead(pos)) {
+                        components.emplace_back(pos, wto.componentEnd(pos));
+                    }
+                    ++pos;
+                    continue;
+                }
+                if (components.empty()) {
+                    break;
+                }
+                unsigned head_pos = components.back().first;
+                countTransfer(wto[head_pos], head_pos, last_pos, _stats);
+                if (transferBlock(wto[head_pos])) {
+                    pos = head_pos + 1;
                 } else {
-                    // initialB <- MeetOp(MeetOperands(bb));
-#ifndef LA
-                    initialBV = MeetOp(MeetOperands(bb));
-#else
-                    initialBV = MeetOp(bb);
-#endif
+                    components.pop_back();
                 }
-                inputBV = initialBV;
-                for (auto &inst : InstTraversalOrder(bb)) {
-                    changed |= TransferFunc(inst, inputBV, _inst_bv_map.at(&inst));
-                    //顺着数据流分析的方向，上一条指令的"output"即下一条指令的"input"
-                    inputBV = _inst_bv_map.at(&inst);
+            }
+        }
+
+        /// @brief  按遍历顺序给基本块编号并建立CFG快照, 然后从arena中为gen/kill/state分配矩阵
+        void allocateStates(const Function &F) {
+            _cfg.build(BBTraversalOrder(F));
+            _bb_gen.allocate(_arena, _cfg.size(), _domain.size());
+            _bb_kill.allocate(_arena, _cfg.size(), _domain.size());
+            _bb_bv.allocate(_arena, _cfg.size(), _domain.size());
+            summarizeEdges();
+        }
+
+        /// @brief 补全本次求解的domain大小和state占用的字节数, 并累加到LLVM Statistic中
+        void recordStatistics() {
+            _stats.domain_size = _domain.size();
+            _stats.state_bytes = _bb_gen.bytes() + _bb_kill.bytes() + _bb_bv.bytes() + _edge_kill.bytes();
+            RecordSolverStatistics(_stats);
+        }
+
+        /// @brief  丢弃所有state, 并一次性释放arena
+        void releaseStates() {
+            _cfg.clear();
+            _bb_gen.clear();
+            _bb_kill.clear();
+            _bb_bv.clear();
+            _edge_kill.clear();
+            _inst_idx.clear();
+            _inst_bv.clear();
+            _materialized = BitSet();
+            _dirty = BitSet();
+            _cfg_dirty = _domain_dirty = false;
+            _arena.Reset();
+        }
+
+    protected:
+        /// @brief 返回指令@p inst 经过传递函数之后的state, 第一次查询时重建其所在基本块的所有state
+        const set_t &InstBV(const Instruction &inst) const {
+            if (_inst_bv.empty()) {
+                // 第一次查询时才建立指令到编号的索引, 同一个基本块的指令占据连续的行
+                ArrayRef<const Instruction *> insts = _cfg.insts();
+                for (unsigned inst_idx = 0; inst_idx < insts.size(); ++inst_idx) {
+                    _inst_idx[insts[inst_idx]] = inst_idx;
                 }
+                _inst_bv.allocate(_arena, _cfg.numInsts(), _domain.size());
+                _materialized = BitSet(_cfg.size());
+            }
+            unsigned bb_idx = BlockIdx(*inst.getParent());
+            if (!_materialized.test(bb_idx)) {
+                materializeBlock(bb_idx, _inst_bv.slice(_cfg.instBegin(bb_idx), _cfg.insts(bb_idx).size()));
+                _materialized.set(bb_idx);
+            }
+            return _inst_bv[_inst_idx.lookup(&inst)];
+        }
+
+        /// @brief 在分析每个函数之前清空domain, 子类若有依附于domain的索引, 需定义同名方法一并清空
+        void ClearDomain() {
+            _domain.clear();
+        }
+
+        /***********************************************************************
+         * Incremental Re-analysis
+         ***********************************************************************/
+    private:
+        /// @brief 返回@p lhs - @p rhs
+        static set_t Minus(const set_t &lhs, const set_t &rhs) {
+            set_t result = lhs;
+            result.reset(rhs);
+            return result;
+        }
+
+        /// @brief @p lhs 与@p rhs 是否相交
+        static bool Intersects(const set_t &lhs, const set_t &rhs) {
+            return Minus(lhs, rhs) != lhs;
+        }
+
+        /// @brief  把旧domain编号下的@p old_row 按@p new_of 搬到现在的domain编号下写入@p row ,
+        ///         旧domain中已经不存在的元素被丢弃, 新增的元素取@p fill
+        void remapRow(const set_t &old_row, ArrayRef<int> new_of, bool fill, set_t &row) const {
+            row = set_t(_domain.size(), fill);
+            if (!fill) {
+                for (unsigned old_idx : old_row.set_bits()) {
+                    if (new_of[old_idx] != -1) {
+                        row.set(new_of[old_idx]);
+                    }
+                }
+                return;
+            }
+            // 默认为全集时只需要搬运旧集合中为0的位置
+            set_t zeros = Minus(set_t(old_row.size(), true), old_row);
+            for (unsigned old_idx : zeros.set_bits()) {
+                if (new_of[old_idx] != -1) {
+                    row.reset(new_of[old_idx]);
+                }
+            }
+        }
+
+        /// @brief  比较同一个基本块修改前后的传递函数 f(x) = gen ∪ (x - kill), 返回传递函数在格中"变高"的元素.
+        ///         每个元素上的传递函数只有三种: 常数(gen), 清零(kill - gen)和恒等, 这三种在"元素更多"的意义下
+        ///         依次变小; 对Top为空集的格(并集), 元素更少即更高, 反之亦然.
+        static set_t RaisedElements(const set_t &old_gen, const set_t &old_kill,
+                                    const set_t &new_gen, const set_t &new_kill) {
+            const bool top_is_empty = TMeetOp::top_is_empty_c;
+            const set_t &lower_gen = top_is_empty ? old_gen : new_gen, &lower_kill = top_is_empty ? old_kill : new_kill;
+            const set_t &upper_gen = top_is_empty ? new_gen : old_gen, &upper_kill = top_is_empty ? new_kill : old_kill;
+            // 从gen变为非gen, 或者从非清零变为清零
+            set_t raised = Minus(lower_gen, upper_gen);
+            raised |= Minus(Minus(upper_kill, upper_gen), Minus(lower_kill, lower_gen));
+            return raised;
+        }
+
+        /// @brief 比较同一条边修改前后的kill, 返回meet的结果在格中"变高"的元素
+        static set_t RaisedEdgeElements(const set_t &old_kill, const set_t &new_kill) {
+            return TMeetOp::top_is_empty_c ? Minus(new_kill, old_kill) : Minus(old_kill, new_kill);
+        }
+
+        /// @brief 把@p row 中属于@p elems 的位置设为Top
+        static void ResetToTop(set_t &row, const set_t &elems) {
+            if (TMeetOp::top_is_empty_c) {
+                row.reset(elems);
+            } else {
+                row |= elems;
+            }
+        }
+
+        void markDirty(const BasicBlock &bb) {
+            if (_cfg.contains(bb)) {
+                _dirty.set(_cfg.index(bb));
+            } else {
+                _cfg_dirty = true;
             }
-            return changed;
         }
 
     public:
-        Framework(char ID) : FunctionPass(ID) {}
+        /// @brief 通知框架: 指令@p inst 已经插入到它现在所在的基本块中
+        void instructionInserted(const Instruction &inst) {
+            markDirty(*inst.getParent());
+            _domain_dirty = true;
+        }
 
-        virtual ~Framework() override {}
+        /// @brief 通知框架: 指令@p inst 即将被删除, 必须在删除之前调用
+        void instructionErased(const Instruction &inst) {
+            markDirty(*inst.getParent());
+            _domain_dirty = true;
+        }
 
-        // We don't modify the program, so we preserve all analysis.
-        virtual void getAnalysisUsage(AnalysisUsage &AU) const override {
-            AU.setPreservesAll();
+        /// @brief 通知框架: 指令@p inst 已经从基本块@p from 移动到它现在所在的位置(可以是同一个基本块)
+        void instructionMoved(const Instruction &inst, const BasicBlock &from) {
+            markDirty(from);
+            markDirty(*inst.getParent());
+            // domain按元素第一次出现的顺序编号, 移动指令可能改变这个顺序
+            _domain_dirty = true;
         }
 
-    protected:
-        /// @brief 依据每条inst来初始化domain
-        /// @todo  Override this method in every child class.
-        virtual void InitializeDomainFromInstruction(const Instruction &inst) = 0;
+        /// @brief 通知框架: 指令@p inst 的操作数被修改
+        void instructionChanged(const Instruction &inst) {
+            markDirty(*inst.getParent());
+            _domain_dirty = true;
+        }
+
+        /// @brief 通知框架: IR没有改变, 但指令@p inst 的gen/kill(取决于子类的外部状态)改变了, domain不受影响
+        void transferChanged(const Instruction &inst) {
+            markDirty(*inst.getParent());
+        }
+
+        /// @brief 通知框架: 值@p val 的所有use即将被替换(例如replaceAllUsesWith), 必须在替换之前调用
+        void usesReplaced(const Value &val) {
+            for (const User *user : val.users()) {
+                if (const auto *user_inst = dyn_cast<Instruction>(user)) {
+                    instructionChanged(*user_inst);
+                }
+            }
+        }
+
+        /// @brief  在通知过的修改之后增量地更新上一次run()的结果, 结果与对修改后的@p F 重新run()相同.
+        ///         CFG(基本块或边)发生变化时退回完整的run().
+        ///
+        ///         旧的不动点对没有受影响的基本块仍然成立. 对被修改的基本块比较修改前后的传递函数:
+        ///           - 只在格中"变低"的元素: 从旧的state出发继续迭代即可收敛到新的不动点, 不再改变时停止;
+        ///           - "变高"的元素: 沿数据流方向可达的基本块中这些元素的state要先重置为Top, 再重新迭代.
+        ///         domain中新增的元素在所有基本块中从Top开始, 只有在它们身上有gen/kill的基本块和边界需要重新计算.
+        ///         数据流方程逐个元素相互独立, 上面三种情况可以在同一次迭代中完成, worklist只包含受影响的基本块.
+        void update(const Function &F) {
+            if (!_cfg_dirty && !_dirty.any()) {
+                return;
+            }
+            if (_cfg_dirty || !_cfg.matches(F)) {
+                run(F);
+                return;
+            }
+            _cfg.refreshInsts();
+            unsigned num_blocks = _cfg.size();
+            BitSet dirty = std::move(_dirty);
+            _dirty = BitSet(num_blocks);
+
+            // 旧的state保留在旧的arena中直到更新结束, 新的state从新的arena中分配
+            BumpPtrAllocator old_arena = std::move(_arena);
+            _arena.Reset();
+            matrix_t old_gen = std::move(_bb_gen), old_kill = std::move(_bb_kill);
+            matrix_t old_bv = std::move(_bb_bv), old_edge_kill = std::move(_edge_kill);
+            _inst_idx.clear();
+            _inst_bv.clear();
+            _materialized = BitSet();
+
+            // 重新建立domain, new_of为旧编号到新编号的映射, 新增的元素没有旧编号
+            std::vector<int> new_of;
+            BitSet new_elems;
+            bool same_domain = true;
+            if (_domain_dirty) {
+                Domain<TDomainElement> old_domain = _domain;
+                derived().ClearDomain();
+                for (const auto &inst : instructions(F)) {
+                    derived().InitializeDomainFromInstruction(inst);
+                }
+                new_of.assign(old_domain.size(), -1);
+                new_elems = BitSet(_domain.size(), true);
+                for (unsigned new_idx = 0; new_idx < _domain.size(); ++new_idx) {
+                    int old_idx = old_domain.position(_domain[new_idx]);
+                    if (old_idx != -1) {
+                        new_of[old_idx] = new_idx;
+                        new_elems.reset(new_idx);
+                    }
+                    same_domain &= old_idx == int(new_idx);
+                }
+                same_domain &= old_domain.size() == _domain.size();
+                _domain_dirty = false;
+            }
+            unsigned domain_size = _domain.size();
+            if (same_domain) {
+                new_elems = BitSet(domain_size);
+            }
+            set_t new_elems_set(domain_size);
+            for (unsigned elem_idx : new_elems.set_bits()) {
+                new_elems_set.set(elem_idx);
+            }
+
+            _bb_gen.allocate(_arena, num_blocks, domain_size);
+            _bb_kill.allocate(_arena, num_blocks, domain_size);
+            _bb_bv.allocate(_arena, num_blocks, domain_size);
+            summarizeEdges();
+
+            // seeds: 需要重新计算的基本块; raised/origins: 变高的元素以及它们的来源
+            BitSet seeds(num_blocks), origins(num_blocks);
+            set_t raised(domain_size), old_gen_row, old_kill_row;
+            for (unsigned bb_idx = 0; bb_idx < num_blocks; ++bb_idx) {
+                const bool top_is_empty = TMeetOp::top_is_empty_c;
+                if (same_domain) {
+                    _bb_bv[bb_idx] = old_bv[bb_idx];
+                } else {
+                    remapRow(old_bv[bb_idx], new_of, !top_is_empty, _bb_bv[bb_idx]);
+                }
+                // domain改变时编号全部重排, 所有基本块都重新计算摘要并与旧的摘要比较
+                if (same_domain && !dirty.test(bb_idx)) {
+                    _bb_gen[bb_idx] = old_gen[bb_idx];
+                    _bb_kill[bb_idx] = old_kill[bb_idx];
+                    continue;
+                }
+                summarizeBlock(bb_idx);
+                if (same_domain) {
+                    old_gen_row = old_gen[bb_idx];
+                    old_kill_row = old_kill[bb_idx];
+                } else {
+                    remapRow(old_gen[bb_idx], new_of, false, old_gen_row);
+                    remapRow(old_kill[bb_idx], new_of, false, old_kill_row);
+                }
+                if (old_gen_row != _bb_gen[bb_idx] || old_kill_row != _bb_kill[bb_idx]) {
+                    seeds.set(bb_idx);
+                    set_t bb_raised = Minus(RaisedElements(old_gen_row, old_kill_row, _bb_gen[bb_idx], _bb_kill[bb_idx]),
+                                            new_elems_set);
+                    if (bb_raised.any()) {
+                        raised |= bb_raised;
+                        origins.set(bb_idx);
+                    }
+                }
+                if (new_elems.any() && (Intersects(_bb_gen[bb_idx], new_elems_set) ||
+                                        Intersects(_bb_kill[bb_idx], new_elems_set))) {
+                    seeds.set(bb_idx);
+                }
+            }
+            // 边上的kill改变时, 影响的是以这条边为meet operand的基本块
+            if (HasEdgeKill()) {
+                set_t old_edge_row;
+                for (unsigned bb_idx = 0; bb_idx < num_blocks; ++bb_idx) {
+                    unsigned edge_idx = MeetEdgeBegin(bb_idx);
+                    for (unsigned k = 0; k < MeetOperands(bb_idx).size(); ++k, ++edge_idx) {
+                        if (same_domain) {
+                            old_edge_row = old_edge_kill[edge_idx];
+                        } else {
+                            remapRow(old_edge_kill[edge_idx], new_of, false, old_edge_row);
+                        }
+                        const set_t &edge_row = _edge_kill[edge_idx];
+                        if (old_edge_row != edge_row || (new_elems.any() && Intersects(edge_row, new_elems_set))) {
+                            seeds.set(bb_idx);
+                        }
+                        set_t edge_raised = Minus(RaisedEdgeElements(old_edge_row, edge_row), new_elems_set);
+                        if (edge_raised.any()) {
+                            raised |= edge_raised;
+                            origins.set(bb_idx);
+                        }
+                    }
+                }
+            }
+            // 新增元素在边界处取BC而不是Top
+            if (new_elems.any()) {
+                for (unsigned bb_idx = 0; bb_idx < num_blocks; ++bb_idx) {
+                    if (IsBoundary(bb_idx)) {
+                        seeds.set(bb_idx);
+                    }
+                }
+            }
+            // 从变高的来源出发沿数据流方向把这些元素重置为Top
+            if (origins.any()) {
+                std::vector<unsigned> stack;
+                for (unsigned bb_idx : origins.set_bits()) {
+                    stack.push_back(bb_idx);
+                }
+                BitSet reached = origins;
+                while (!stack.empty()) {
+                    unsigned bb_idx = stack.back();
+                    stack.pop_back();
+                    ResetToTop(_bb_bv[bb_idx], raised);
+                    seeds.set(bb_idx);
+                    for (unsigned dep_idx : Dependents(bb_idx)) {
+                        if (!reached.test(dep_idx)) {
+                            reached.set(dep_idx);
+                            stack.push_back(dep_idx);
+                        }
+                    }
+                }
+            }
+            _stats = SolverStatistics();
+            {
+                TimeTraceScope scope("DFA Solve", F.getName());
+                solve(std::move(seeds));
+            }
+            recordStatistics();
+        }
 
     public:
-        virtual bool runOnFunction(Function &F) override final {
-            //遍历每条指令，初始化domain
-            for (const auto &inst : instructions(F)) {
-                InitializeDomainFromInstruction(inst);
+        /// @brief 求解函数@p F , 结果一直保留到下一次run()或release()
+        void run(const Function &F) {
+            releaseStates();
+            _stats = SolverStatistics();
+            // 各个阶段在-time-trace中分别计时, 以函数名为detail
+            {
+                TimeTraceScope scope("DFA Domain Init", F.getName());
+                derived().ClearDomain();
+                //遍历每条指令，初始化domain
+                for (const auto &inst : instructions(F)) {
+                    derived().InitializeDomainFromInstruction(inst);
+                }
+            }
+            {
+                TimeTraceScope scope("DFA IC Fill", F.getName());
+                //给基本块编号并分配矩阵, 计算每个基本块的gen/kill, 并将每个基本块的state初始化为IC
+                allocateStates(F);
+                const set_t ic = derived().IC();
+                for (unsigned bb_idx = 0; bb_idx < _cfg.size(); ++bb_idx) {
+                    summarizeBlock(bb_idx);
+                    _bb_bv[bb_idx] = ic;
+                }
+            }
+            _dirty = BitSet(_cfg.size());
+            {
+                TimeTraceScope scope("DFA Solve", F.getName());
+                // 求解直到basicblock-bv不发生变化; 基本块足够多时按强连通分量并行求解
+                ThreadPoolStrategy strategy = hardware_concurrency(_options.threads);
+                if (_cfg.size() >= ParallelSolveMinBlocks && strategy.compute_thread_count() > 1) {
+                    solveParallel(strategy);
+                } else if (_options.strategy == IterationStrategy::WTO) {
+                    solveWTO();
+                } else {
+                    solve();
+                }
+            }
+            recordStatistics();
+        }
+
+        /// @brief 设置之后的run()使用的求解选项
+        void setOptions(const SolverOptions &options) {
+            _options = options;
+        }
+
+        /// @brief 上一次run()中基本块的传递函数被求值的次数, 用来比较不同的迭代策略
+        uint64_t numTransferEvaluations() const {
+            return _stats.transfers;
+        }
+
+        /// @brief 上一次run()或update()的迭代轮数, 求值/meet次数, domain大小以及state占用的内存
+        const SolverStatistics &solverStatistics() const {
+            return _stats;
+        }
+
+        /// @brief 一次性释放上一次run()的所有state
+        void release() {
+            releaseStates();
+        }
+
+        const Domain<TDomainElement> &domain() const {
+            return _domain;
+        }
+
+        /// @brief 按程序顺序(与分析方向无关), 基本块@p bb 入口处的state
+        set_t BlockIn(const BasicBlock &bb) const {
+            unsigned bb_idx = BlockIdx(bb);
+            return direction_c == Direction::Forward ? BlockInput(bb_idx) : _bb_bv[bb_idx];
+        }
+
+        /// @brief 按程序顺序(与分析方向无关), 基本块@p bb 出口处的state
+        set_t BlockOut(const BasicBlock &bb) const {
+            unsigned bb_idx = BlockIdx(bb);
+            return direction_c == Direction::Forward ? _bb_bv[bb_idx] : BlockInput(bb_idx);
+        }
+
+        /// @brief 按程序顺序(与分析方向无关), 指令@p inst 之前的state
+        set_t InstIn(const Instruction &inst) const {
+            if (direction_c == Direction::Backward) {
+                return InstBV(inst);
             }
-            //向_inst_bv_map依次添加初始状态的instruction-bv键值对
-            for (const auto &inst : instructions(F)) {
-                _inst_bv_map.emplace(&inst, IC());
+            const Instruction *prev = inst.getPrevNode();
+            return prev != nullptr ? InstBV(*prev) : BlockInput(BlockIdx(*inst.getParent()));
+        }
+
+        /// @brief 按程序顺序(与分析方向无关), 指令@p inst 之后的state
+        set_t InstOut(const Instruction &inst) const {
+            if (direction_c == Direction::Forward) {
+                return InstBV(inst);
             }
-            // 不断遍历CFG,直到instruction-bv不发生变化
-            while (traverseCFG(F)) {}
-            // dump结果
-            printInstBVMap(F);
-            return false;
+            const Instruction *next = inst.getNextNode();
+            return next != nullptr ? InstBV(*next) : BlockInput(BlockIdx(*inst.getParent()));
         }
 
 #undef METHOD_ENABLE_IF_DIRECTION
     };
 }
-#endif //ASSIGNMENT2_FRAMEWORK_H
\ No newline at end of file
+#endif //ASSIGNMENT2_FRAMEWORK_H
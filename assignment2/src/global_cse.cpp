@@ -0,0 +1,122 @@
+//
+// Created by sakura on 2026/10/17.
+//
+
+// 由available expressions驱动的全局公共子表达式消除:
+//   opt -load libAssignment2.so -global-cse input.ll -S -o output.ll
+//   opt -load-pass-plugin=libAssignment2.so -passes='global-cse' input.ll -S -o output.ll
+
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <llvm/ADT/DepthFirstIterator.h>
+#include <llvm/ADT/STLExtras.h>
+#include <llvm/ADT/Statistic.h>
+#include <llvm/IR/Dominators.h>
+#include <llvm/Pass.h>
+#include "avail_expr.h"
+#include "global_cse.h"
+
+#define DEBUG_TYPE "global-cse"
+
+using namespace llvm;
+
+STATISTIC(NumEliminated, "Number of redundant instructions eliminated");
+
+namespace {
+    class LegacyGlobalCSEPass final : public FunctionPass {
+    public:
+        static char ID;
+
+        LegacyGlobalCSEPass() : FunctionPass(ID) {}
+
+        virtual ~LegacyGlobalCSEPass() override {}
+
+        virtual void getAnalysisUsage(AnalysisUsage &AU) const override {
+            AU.addRequired<DominatorTreeWrapperPass>();
+            AU.setPreservesCFG();
+        }
+
+        virtual bool runOnFunction(Function &F) override {
+            const DominatorTree &dom_tree = getAnalysis<DominatorTreeWrapperPass>().getDomTree();
+            return dfa::RunGlobalCSE(F, dom_tree) != 0;
+        }
+    };
+
+    char LegacyGlobalCSEPass::ID = 0;
+
+    RegisterPass<LegacyGlobalCSEPass> X(
+            "global-cse", "Global Common Subexpression Elimination (driven by Available Expressions)");
+
+    /// @brief  在不修改IR的前提下找出可以消除的指令以及替换它的指令:
+    ///         按支配树的先序遍历, 支配者总是先于被支配者被访问, 每个表达式记录目前为止没有被消除的实例.
+    ///         表达式在指令之前可用时, 在这些实例中寻找支配该指令的一个.
+    std::vector<std::pair<Instruction *, Instruction *>>
+    FindRedundancies(Function &F, const DominatorTree &dom_tree, const dfa::AvailExpr &analysis) {
+        std::vector<std::pair<Instruction *, Instruction *>> redundancies;
+        std::unordered_map<dfa::Expression, SmallVector<Instruction *, 2>> instances;
+        for (const DomTreeNode *node : depth_first(dom_tree.getRootNode())) {
+            for (Instruction &inst : *node->getBlock()) {
+                if (!dfa::Expression::IsExpression(inst)) {
+                    continue;
+                }
+                dfa::Expression expr(inst);
+                SmallVector<Instruction *, 2> &expr_instances = instances[expr];
+                Instruction *leader = nullptr;
+                if (!expr_instances.empty() && analysis.isAvailableBefore(expr, inst)) {
+                    for (Instruction *instance : expr_instances) {
+                        if (dom_tree.dominates(instance, &inst)) {
+                            leader = instance;
+                            break;
+                        }
+                    }
+                }
+                if (leader != nullptr) {
+                    redundancies.emplace_back(&inst, leader);
+                } else {
+                    expr_instances.push_back(&inst);
+                }
+            }
+        }
+        return redundancies;
+    }
+} // namespace anonymous
+
+namespace dfa {
+    unsigned RunGlobalCSE(Function &F, const DominatorTree &dom_tree) {
+        AvailExpr analysis;
+        analysis.run(F);
+        unsigned num_eliminated = 0;
+        // 消除一条指令之后, 以它为操作数的表达式变成以替换它的指令为操作数, 可能与其他表达式相同,
+        // 所以增量地更新available expressions并重复, 直到不再有可以消除的指令
+        while (true) {
+            std::vector<std::pair<Instruction *, Instruction *>> redundancies = FindRedundancies(F, dom_tree, analysis);
+            if (redundancies.empty()) {
+                break;
+            }
+            for (const auto &redundancy : redundancies) {
+                Instruction *inst = redundancy.first, *leader = redundancy.second;
+                // leader的nsw/exact/inbounds等标志只有两条指令都有时才能保留
+                leader->andIRFlags(inst);
+                analysis.usesReplaced(*inst);
+                inst->replaceAllUsesWith(leader);
+                analysis.instructionErased(*inst);
+                inst->eraseFromParent();
+            }
+            num_eliminated += redundancies.size();
+            analysis.update(F);
+        }
+        NumEliminated += num_eliminated;
+        return num_eliminated;
+    }
+
+    PreservedAnalyses GlobalCSEPass::run(Function &F, FunctionAnalysisManager &FAM) {
+        if (RunGlobalCSE(F, FAM.getResult<DominatorTreeAnalysis>(F)) == 0) {
+            return PreservedAnalyses::all();
+        }
+        PreservedAnalyses PA;
+        PA.preserveSet<CFGAnalyses>();
+        return PA;
+    }
+}
@@ -0,0 +1,23 @@
+//
+// Created by sakura on 2026/10/17.
+//
+
+#ifndef ASSIGNMENT2_GLOBAL_CSE_H
+#define ASSIGNMENT2_GLOBAL_CSE_H
+
+#include <llvm/IR/Dominators.h>
+#include <llvm/IR/Function.h>
+#include <llvm/IR/PassManager.h>
+
+namespace dfa {
+    /// @brief  全局公共子表达式消除: 用available expressions找出在某条指令之前已经被计算过的表达式,
+    ///         把这条指令替换为支配它的等价指令, 直到不再有可以消除的指令. 返回被消除的指令数
+    unsigned RunGlobalCSE(llvm::Function &F, const llvm::DominatorTree &dom_tree);
+
+    /// New-PM Global CSE Pass
+    class GlobalCSEPass : public llvm::PassInfoMixin<GlobalCSEPass> {
+    public:
+        llvm::PreservedAnalyses run(llvm::Function &F, llvm::FunctionAnalysisManager &FAM);
+    };
+}
+#endif //ASSIGNMENT2_GLOBAL_CSE_H
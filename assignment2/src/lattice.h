@@ -0,0 +1,350 @@
+//
+// Created by sakura on 2026/10/17.
+//
+
+#ifndef ASSIGNMENT2_LATTICE_H
+#define ASSIGNMENT2_LATTICE_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <llvm/ADT/DenseMap.h>
+#include <llvm/ADT/SmallVector.h>
+#include <llvm/IR/Function.h>
+#include <llvm/IR/Instructions.h>
+#include <llvm/Support/raw_ostream.h>
+#include "bitset.h"
+#include "cfg.h"
+#include "framework.h"
+#include "output.h"
+
+namespace dfa {
+    /***********************************************************************
+     * Lattice
+     ***********************************************************************/
+    // LatticeFramework中每个值的格元素TValue需要提供:
+    //   TValue():                       Top, 即"还没有任何信息", 也是meet operation的单位元
+    //   bool meet(const TValue &other): *this <- *this ∧ other, 返回*this是否改变
+    //   bool operator==(const TValue &other) const
+    //   raw_ostream &operator<<(raw_ostream &, const TValue &)
+    // 格的高度可以是无限的(例如整数区间), 这时子类需要提供Widen, 保证每个值只会被降低有限次.
+
+    /// Sparse Lattice Dataflow Framework
+    ///
+    /// Framework在每个基本块上保存一个幂集格上的集合; 这里的格是任意的, 而state按SSA值保存:
+    /// 每个值只有一个定义, 它在定义所支配的所有程序点上都相同, 所以整个函数中每个值只需要一个格元素.
+    /// 求解器是Wegman-Zadeck的conditional propagation, 同时维护两个worklist:
+    ///   - CFG worklist: 新变为可执行的基本块, 第一次到达时对其中所有指令求值, 之后有新的入边可执行时只重新对phi求值;
+    ///   - SSA worklist: 格元素改变的指令, 它们在可执行基本块中的user需要重新求值.
+    /// terminator的求值结果是它的哪些出边可执行, 由子类根据条件的格元素决定, 常量条件的另一侧永远不会被执行;
+    /// 从不可执行的边流入的值不参与phi的meet, 不可执行的基本块中的指令保持Top.
+    ///
+    /// 子类通过CRTP把自己作为@p TDerived 传入, 需要提供(可以是protected, 但需要将框架声明为friend):
+    ///   TValue Transfer(const Instruction &inst) const;
+    ///                           phi和terminator以外的指令的格元素, 通过getValue查询操作数
+    ///   TValue ValueOf(const Value &val) const;
+    ///                           指令以外的值(参数, 常量, 全局变量等)的格元素
+    ///   void FeasibleSuccessors(const Instruction &term, SmallVectorImpl<bool> &feasible) const;
+    ///                           terminator的哪些出边可执行, @p feasible 按后继的顺序, 初始全为false
+    /// 以及可选的Widen.
+    ///
+    /// @tparam TDerived Concrete Analysis
+    /// @tparam TValue   Lattice Element
+    template<class TDerived, class TValue>
+    class LatticeFramework {
+    public:
+        typedef TValue value_t;
+
+    private:
+        TDerived &derived() { return *static_cast<TDerived *>(this); }
+
+        const TDerived &derived() const { return *static_cast<const TDerived *>(this); }
+
+        //基本块按布局顺序编号, 指令的编号即其在_cfg中的编号
+        CFGSnapshot _cfg;
+        llvm::DenseMap<const llvm::Instruction *, unsigned> _inst_idx;
+        //每条指令的格元素
+        std::vector<TValue> _values;
+        //可执行的基本块, 以及可执行的边(以边在_cfg.succs中的编号为下标)
+        BitSet _executable, _feasible;
+        //phi的格元素被降低的次数, 以及需要widening的基本块(WTO中分量的head, 即循环的入口)
+        std::vector<unsigned> _num_lowered;
+        BitSet _widening_blocks;
+        //两个worklist, 以及SSA worklist中已有的指令
+        std::vector<unsigned> _block_worklist, _inst_worklist;
+        BitSet _in_inst_worklist;
+        //上一次run()中指令被求值的次数
+        uint64_t _num_evals = 0;
+
+    protected:
+        //不在循环入口的phi被降低超过这个次数之后也进行widening. 对一般的CFG, 每个环都经过某个WTO分量的head,
+        //但值的环上的phi不一定在head中, 这里保证格的高度无限时迭代也总能终止.
+        static constexpr unsigned WideningDelay = 8;
+
+    private:
+        /// @brief 把编号为@p bb_idx 的基本块标记为可执行, 第一次标记时放入CFG worklist
+        void markExecutable(unsigned bb_idx) {
+            if (!_executable.test(bb_idx)) {
+                _executable.set(bb_idx);
+                _block_worklist.push_back(bb_idx);
+            }
+        }
+
+        /// @brief 把编号为@p bb_idx 的基本块的第@p succ_pos 条出边标记为可执行
+        void markFeasible(unsigned bb_idx, unsigned succ_pos) {
+            unsigned edge_idx = _cfg.succBegin(bb_idx) + succ_pos;
+            if (_feasible.test(edge_idx)) {
+                return;
+            }
+            _feasible.set(edge_idx);
+            unsigned succ_idx = _cfg.succs(bb_idx)[succ_pos];
+            if (!_executable.test(succ_idx)) {
+                markExecutable(succ_idx);
+                return;
+            }
+            // 后继已经求值过, 新的入边只影响其中的phi
+            for (const llvm::Instruction *inst : _cfg.insts(succ_idx)) {
+                if (!llvm::isa<llvm::PHINode>(inst)) {
+                    break;
+                }
+                evaluate(_inst_idx.lookup(inst));
+            }
+        }
+
+        /// @brief 用@p value 降低编号为@p inst_idx 的指令的格元素, 改变时放入SSA worklist
+        void lower(unsigned inst_idx, const TValue &value) {
+            TValue next = _values[inst_idx];
+            if (!next.meet(value)) {
+                return;
+            }
+            if (const auto *phi = llvm::dyn_cast<llvm::PHINode>(_cfg.insts()[inst_idx])) {
+                if (_widening_blocks.test(_cfg.index(*phi->getParent())) || ++_num_lowered[inst_idx] > WideningDelay) {
+                    derived().Widen(*phi, _values[inst_idx], next);
+                }
+            }
+            _values[inst_idx] = std::move(next);
+            if (!_in_inst_worklist.test(inst_idx)) {
+                _in_inst_worklist.set(inst_idx);
+                _inst_worklist.push_back(inst_idx);
+            }
+        }
+
+        /// @brief 对编号为@p inst_idx 的指令求值, 要求它所在的基本块可执行
+        void evaluate(unsigned inst_idx) {
+            const llvm::Instruction *inst = _cfg.insts()[inst_idx];
+            ++_num_evals;
+            if (inst->isTerminator()) {
+                unsigned bb_idx = _cfg.index(*inst->getParent());
+                llvm::SmallVector<bool, 4> feasible(_cfg.succs(bb_idx).size(), false);
+                derived().FeasibleSuccessors(*inst, feasible);
+                for (unsigned succ_pos = 0; succ_pos < feasible.size(); ++succ_pos) {
+                    if (feasible[succ_pos]) {
+                        markFeasible(bb_idx, succ_pos);
+                    }
+                }
+                // 有结果的terminator(例如invoke)
+                if (!inst->getType()->isVoidTy()) {
+                    lower(inst_idx, derived().Transfer(*inst));
+                }
+                return;
+            }
+            if (const auto *phi = llvm::dyn_cast<llvm::PHINode>(inst)) {
+                // 只meet从可执行的边流入的值
+                TValue value;
+                for (unsigned op_idx = 0; op_idx < phi->getNumIncomingValues(); ++op_idx) {
+                    if (isFeasible(*phi->getIncomingBlock(op_idx), *phi->getParent())) {
+                        value.meet(getValue(phi->getIncomingValue(op_idx)));
+                    }
+                }
+                lower(inst_idx, value);
+                return;
+            }
+            lower(inst_idx, derived().Transfer(*inst));
+        }
+
+    protected:
+        /// @brief  在循环入口的phi上扩展格元素, 保证迭代终止. @p old_value 为phi原来的格元素,
+        ///         @p value 为meet了新的incoming之后的格元素, 可以把它进一步降低(例如把区间的上界放宽到无穷).
+        ///         默认不做任何事, 格的高度有限时不需要widening.
+        void Widen(const llvm::PHINode &phi, const TValue &old_value, TValue &value) const {}
+
+    public:
+        /// @brief 求解器的选项对稀疏求解器没有影响, 只是为了可以与Framework的子类一样被包装成pass
+        void setOptions(const SolverOptions &) {}
+
+        /// @brief 上一次run()中指令被求值的次数
+        uint64_t numTransferEvaluations() const { return _num_evals; }
+
+        /// @brief 求解函数@p F , 结果一直保留到下一次run()或release()
+        void run(const llvm::Function &F) {
+            release();
+            std::vector<const llvm::BasicBlock *> order;
+            order.reserve(F.size());
+            for (const llvm::BasicBlock &bb : F) {
+                order.push_back(&bb);
+            }
+            _cfg.build(order);
+            llvm::ArrayRef<const llvm::Instruction *> insts = _cfg.insts();
+            for (unsigned inst_idx = 0; inst_idx < insts.size(); ++inst_idx) {
+                _inst_idx[insts[inst_idx]] = inst_idx;
+            }
+            _values.assign(insts.size(), TValue());
+            _num_lowered.assign(insts.size(), 0);
+            _executable = BitSet(_cfg.size());
+            _feasible = BitSet(_cfg.numEdges());
+            _in_inst_worklist = BitSet(insts.size());
+            // WTO中分量的head就是循环的入口, 每个环都经过至少一个head
+            WeakTopologicalOrder wto;
+            wto.build(_cfg, true);
+            _widening_blocks = BitSet(_cfg.size());
+            for (unsigned pos = 0; pos < wto.size(); ++pos) {
+                if (wto.isHead(pos)) {
+                    _widening_blocks.set(wto[pos]);
+                }
+            }
+            _num_evals = 0;
+            if (_cfg.empty()) {
+                return;
+            }
+            markExecutable(_cfg.index(F.getEntryBlock()));
+            while (!_block_worklist.empty() || !_inst_worklist.empty()) {
+                // 先处理新可执行的基本块, 让尽量多的phi在它们的user被求值之前就得到更多的incoming
+                while (!_block_worklist.empty()) {
+                    unsigned bb_idx = _block_worklist.back();
+                    _block_worklist.pop_back();
+                    unsigned inst_idx = _cfg.instBegin(bb_idx);
+                    for (unsigned pos = 0; pos < _cfg.insts(bb_idx).size(); ++pos) {
+                        evaluate(inst_idx + pos);
+                    }
+                }
+                if (!_inst_worklist.empty()) {
+                    unsigned inst_idx = _inst_worklist.back();
+                    _inst_worklist.pop_back();
+                    _in_inst_worklist.reset(inst_idx);
+                    for (const llvm::User *user : _cfg.insts()[inst_idx]->users()) {
+                        const auto *user_inst = llvm::dyn_cast<llvm::Instruction>(user);
+                        if (user_inst != nullptr && isExecutable(*user_inst->getParent())) {
+                            evaluate(_inst_idx.lookup(user_inst));
+                        }
+                    }
+                }
+            }
+        }
+
+        /// @brief 释放上一次run()的所有结果
+        void release() {
+            _cfg.clear();
+            _inst_idx.clear();
+            _values.clear();
+            _num_lowered.clear();
+            _executable = BitSet();
+            _feasible = BitSet();
+            _widening_blocks = BitSet();
+            _in_inst_worklist = BitSet();
+            _block_worklist.clear();
+            _inst_worklist.clear();
+        }
+
+        /// @brief 基本块@p bb 是否可执行
+        bool isExecutable(const llvm::BasicBlock &bb) const {
+            return _executable.test(_cfg.index(bb));
+        }
+
+        /// @brief 边(@p from -> @p to)是否可执行, 两个基本块之间有多条边时只要有一条可执行即可
+        bool isFeasible(const llvm::BasicBlock &from, const llvm::BasicBlock &to) const {
+            unsigned from_idx = _cfg.index(from), to_idx = _cfg.index(to);
+            unsigned edge_idx = _cfg.succBegin(from_idx);
+            for (unsigned succ_idx : _cfg.succs(from_idx)) {
+                if (succ_idx == to_idx && _feasible.test(edge_idx)) {
+                    return true;
+                }
+                ++edge_idx;
+            }
+            return false;
+        }
+
+        /// @brief 值@p val 的格元素, 指令以外的值由子类的ValueOf决定
+        TValue getValue(const llvm::Value *val) const {
+            if (const auto *inst = llvm::dyn_cast<llvm::Instruction>(val)) {
+                auto iter = _inst_idx.find(inst);
+                return iter == _inst_idx.end() ? TValue() : _values[iter->second];
+            }
+            return derived().ValueOf(*val);
+        }
+
+        /// @brief 指令@p inst 的格元素, 不可执行的基本块中的指令为Top
+        const TValue &getValue(const llvm::Instruction &inst) const {
+            return _values[_inst_idx.lookup(&inst)];
+        }
+
+        /// @brief 打印@p F 中每个基本块是否可执行, 以及每条有结果的指令的格元素. 要求@p F 已经run()过
+        void printInstBVMap(const llvm::Function &F, llvm::raw_ostream &os) const {
+            os << "********************************************" << "\n";
+            os << "* Instruction-Lattice Mapping               " << "\n";
+            os << "********************************************" << "\n";
+            for (const llvm::BasicBlock &bb : F) {
+                os << (isExecutable(bb) ? "Executable:\t" : "Unreachable:\t");
+                bb.printAsOperand(os, false);
+                os << "\n";
+                for (const llvm::Instruction &inst : bb) {
+                    if (inst.getType()->isVoidTy()) {
+                        continue;
+                    }
+                    os << "Instruction: " << inst << "\n";
+                    os << "\t" << getValue(inst) << "\n";
+                }
+            }
+        }
+
+        /// @brief  以结构化的@p format (Binary或JSONL)写出与printInstBVMap相同的内容, 要求@p F 已经run()过.
+        ///         按布局顺序, 每个基本块写出是否可执行, 以及其中每条有结果的指令的格元素(operator<<的字符串).
+        ///         Binary: "DFL1", 函数名, u32 基本块数, 每个基本块: u32 是否可执行, u32 格元素个数, 每个格元素
+        ///         JSONL:  {"function":..., "blocks":[{"executable":true, "values":[...]}, ...]}
+        void writeResults(const llvm::Function &F, OutputFormat format, ResultWriter &writer) const {
+            std::vector<std::string> values;
+            if (format == OutputFormat::Binary) {
+                writer.write("DFL1");
+                writer.writeBytes(F.getName());
+                writer.writeU32(F.size());
+            } else {
+                assert(format == OutputFormat::JSONL && "Only Binary and JSONL are structured formats.");
+                writer.write("{\"function\":");
+                writer.writeJSONString(F.getName());
+                writer.write(",\"blocks\":[");
+            }
+            bool first_bb = true;
+            for (const llvm::BasicBlock &bb : F) {
+                values.clear();
+                for (const llvm::Instruction &inst : bb) {
+                    if (!inst.getType()->isVoidTy()) {
+                        values.push_back(ToString(getValue(inst)));
+                    }
+                }
+                if (format == OutputFormat::Binary) {
+                    writer.writeU32(isExecutable(bb));
+                    writer.writeU32(values.size());
+                    for (const std::string &value : values) {
+                        writer.writeBytes(value);
+                    }
+                    continue;
+                }
+                writer.write(first_bb ? "{\"executable\":" : ",{\"executable\":");
+                first_bb = false;
+                writer.write(isExecutable(bb) ? "true" : "false");
+                writer.write(",\"values\":[");
+                for (unsigned value_idx = 0; value_idx < values.size(); ++value_idx) {
+                    if (value_idx != 0) {
+                        writer.write(',');
+                    }
+                    writer.writeJSONString(values[value_idx]);
+                }
+                writer.write("]}");
+            }
+            if (format == OutputFormat::JSONL) {
+                writer.write("]}\n");
+            }
+        }
+    };
+}
+#endif //ASSIGNMENT2_LATTICE_H
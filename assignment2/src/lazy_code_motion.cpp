@@ -0,0 +1,363 @@
+//
+// Created by sakura on 2026/10/17.
+//
+
+// 由四个数据流分析组合而成的lazy code motion(partial redundancy elimination):
+//   opt -load libAssignment2.so -lazy-code-motion input.ll -S -o output.ll
+//   opt -load-pass-plugin=libAssignment2.so -passes='lazy-code-motion' input.ll -S -o output.ll
+//
+// 按基本块的粒度求解, 所以要先拆分critical edge, 在边上放置计算即在拆分出的基本块的入口处放置.
+// 每个被移动的表达式使用一个alloca作为临时变量, 改写完成后用mem2reg把它们提升为SSA值,
+// 最后把没有放置任何计算的拆分出的基本块合并回去.
+
+#include <vector>
+
+#include <llvm/ADT/SmallPtrSet.h>
+#include <llvm/ADT/Statistic.h>
+#include <llvm/Analysis/ValueTracking.h>
+#include <llvm/IR/CFG.h>
+#include <llvm/IR/Dominators.h>
+#include <llvm/IR/Instructions.h>
+#include <llvm/Pass.h>
+#include <llvm/Transforms/Utils/BasicBlockUtils.h>
+#include <llvm/Transforms/Utils/Local.h>
+#include <llvm/Transforms/Utils/PromoteMemToReg.h>
+#include "lazy_code_motion.h"
+
+#define DEBUG_TYPE "lazy-code-motion"
+
+using namespace llvm;
+using dfa::BitSet;
+
+STATISTIC(NumInserted, "Number of expressions inserted at their latest placement");
+STATISTIC(NumReplaced, "Number of redundant computations replaced");
+
+namespace {
+    /// @brief 指令@p inst 的操作数是否都在它所在的基本块之外定值, 即它计算的表达式在基本块的入口处之前没有被kill
+    bool IsUpwardExposed(const Instruction &inst) {
+        for (const Value *operand : inst.operand_values()) {
+            const auto *operand_inst = dyn_cast<Instruction>(operand);
+            if (operand_inst != nullptr && operand_inst->getParent() == inst.getParent()) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /// @brief 一个表达式的改写: 在哪些基本块的入口处放置计算, 哪些计算的结果要保存到临时变量, 哪些计算被临时变量替换
+    struct ExpressionMotion {
+        Instruction *instance = nullptr;
+        std::vector<BasicBlock *> placements;
+        std::vector<Instruction *> saves;
+        std::vector<Instruction *> redundancies;
+    };
+
+    /// @brief  把拆分critical edge得到的基本块中没有放置任何计算的合并回去, 它们只剩下一条无条件跳转.
+    /// @return 是否所有拆分出的基本块都被合并了
+    bool MergeSplitBlocks(Function &F, const SmallPtrSetImpl<const BasicBlock *> &original_blocks) {
+        std::vector<BasicBlock *> split_blocks;
+        bool all_merged = true;
+        for (BasicBlock &bb : F) {
+            if (original_blocks.count(&bb)) {
+                continue;
+            }
+            if (&bb.front() == bb.getTerminator()) {
+                split_blocks.push_back(&bb);
+            } else {
+                all_merged = false;
+            }
+        }
+        for (BasicBlock *bb : split_blocks) {
+            all_merged &= TryToSimplifyUncondBranchFromEmptyBlock(bb);
+        }
+        return all_merged;
+    }
+
+    class LegacyLazyCodeMotionPass final : public FunctionPass {
+    public:
+        static char ID;
+
+        LegacyLazyCodeMotionPass() : FunctionPass(ID) {}
+
+        virtual ~LegacyLazyCodeMotionPass() override {}
+
+        virtual bool runOnFunction(Function &F) override {
+            return dfa::RunLazyCodeMotion(F);
+        }
+    };
+
+    char LegacyLazyCodeMotionPass::ID = 0;
+
+    RegisterPass<LegacyLazyCodeMotionPass> X(
+            "lazy-code-motion", "Lazy Code Motion (Partial Redundancy Elimination)");
+} // namespace anonymous
+
+namespace dfa {
+    /***********************************************************************
+     * Anticipated Expressions
+     ***********************************************************************/
+    BitSet AnticipatedExpr::IC() const {
+        return BitSet(_domain.size(), true);
+    }
+
+    // 函数的出口之后不会再计算任何表达式
+    BitSet AnticipatedExpr::BC() const {
+        return BitSet(_domain.size(), false);
+    }
+
+    void AnticipatedExpr::GenKill(const Instruction &inst, BitSet &gen, BitSet &kill) const {
+        // 后向: in = e_use ∪ (out - e_kill), 指令的操作数在它之前定值, 所以同一条指令的gen与kill不会相交
+        int expr_idx = ExpressionIdx(inst);
+        if (expr_idx != -1) {
+            gen.set(expr_idx);
+        }
+        KillOperandsOf(inst, kill);
+    }
+
+    /***********************************************************************
+     * Will-be-Available Expressions
+     ***********************************************************************/
+    BitSet WillBeAvailExpr::IC() const {
+        return BitSet(_domain.size(), true);
+    }
+
+    BitSet WillBeAvailExpr::BC() const {
+        return BitSet(_domain.size(), false);
+    }
+
+    void WillBeAvailExpr::GenKill(const Instruction &inst, BitSet &gen, BitSet &kill) const {
+        // out = (anticipated.in ∪ in) - e_kill, anticipated.in作为基本块第一条指令的gen
+        const BasicBlock &bb = *inst.getParent();
+        if (&inst == &bb.front()) {
+            gen |= _anticipated.BlockIn(bb);
+        }
+        // 在操作数定值之后才计算的表达式不会被anticipate, 但计算之后同样可用
+        int expr_idx = ExpressionIdx(inst);
+        if (expr_idx != -1) {
+            gen.set(expr_idx);
+        }
+        KillOperandsOf(inst, kill);
+    }
+
+    /***********************************************************************
+     * Postponable Expressions
+     ***********************************************************************/
+    BitSet PostponableExpr::IC() const {
+        return BitSet(_domain.size(), true);
+    }
+
+    BitSet PostponableExpr::BC() const {
+        return BitSet(_domain.size(), false);
+    }
+
+    void PostponableExpr::GenKill(const Instruction &inst, BitSet &gen, BitSet &kill) const {
+        // out = (earliest ∪ in) - e_use, 被使用的表达式不能推迟到使用之后
+        if (&inst == &inst.getParent()->front()) {
+            gen |= Earliest(*inst.getParent());
+        }
+        int expr_idx = ExpressionIdx(inst);
+        if (expr_idx != -1) {
+            kill.set(expr_idx);
+        }
+    }
+
+    BitSet PostponableExpr::UpwardExposed(const BasicBlock &bb) const {
+        BitSet exposed(_domain.size());
+        for (const Instruction &inst : bb) {
+            int expr_idx = ExpressionIdx(inst);
+            if (expr_idx != -1 && IsUpwardExposed(inst)) {
+                exposed.set(expr_idx);
+            }
+        }
+        return exposed;
+    }
+
+    BitSet PostponableExpr::Earliest(const BasicBlock &bb) const {
+        BitSet earliest = _anticipated.BlockIn(bb);
+        earliest.reset(_available.BlockIn(bb));
+        return earliest;
+    }
+
+    BitSet PostponableExpr::Latest(const BasicBlock &bb) const {
+        BitSet latest = Earliest(bb);
+        latest |= BlockIn(bb);
+        // 在所有后继的入口处都可以放置的表达式还可以继续推迟, 除非在这个基本块中就被使用
+        BitSet postponable_in_succs(_domain.size(), true);
+        for (const BasicBlock *succ : successors(&bb)) {
+            BitSet succ_placeable = Earliest(*succ);
+            succ_placeable |= BlockIn(*succ);
+            postponable_in_succs &= succ_placeable;
+        }
+        BitSet must_place(_domain.size(), true);
+        must_place.reset(postponable_in_succs);
+        must_place |= UpwardExposed(bb);
+        latest &= must_place;
+        return latest;
+    }
+
+    /***********************************************************************
+     * Used Expressions
+     ***********************************************************************/
+    BitSet UsedExpr::IC() const {
+        return BitSet(_domain.size(), false);
+    }
+
+    BitSet UsedExpr::BC() const {
+        return BitSet(_domain.size(), false);
+    }
+
+    void UsedExpr::GenKill(const Instruction &inst, BitSet &gen, BitSet &kill) const {
+        // in = (e_use ∪ out) - latest, latest作为基本块第一条指令的kill, 在整个基本块的gen之后生效
+        int expr_idx = ExpressionIdx(inst);
+        if (expr_idx != -1) {
+            gen.set(expr_idx);
+        }
+        KillOperandsOf(inst, kill);
+        if (&inst == &inst.getParent()->front()) {
+            kill |= _postponable.Latest(*inst.getParent());
+        }
+    }
+
+    /***********************************************************************
+     * Transform
+     ***********************************************************************/
+    bool RunLazyCodeMotion(Function &F) {
+        // 异常处理的基本块和indirectbr/callbr的边无法插入计算或者无法拆分
+        for (const BasicBlock &bb : F) {
+            const Instruction *term = bb.getTerminator();
+            if (bb.isEHPad() || isa<IndirectBrInst>(term) || isa<CallBrInst>(term)) {
+                return false;
+            }
+        }
+        bool changed = removeUnreachableBlocks(F);
+        SmallPtrSet<const BasicBlock *, 32> original_blocks;
+        for (const BasicBlock &bb : F) {
+            original_blocks.insert(&bb);
+        }
+        SplitAllCriticalEdges(F);
+
+        AnticipatedExpr anticipated;
+        anticipated.run(F);
+        WillBeAvailExpr available(anticipated);
+        available.run(F);
+        PostponableExpr postponable(anticipated, available);
+        postponable.run(F);
+        UsedExpr used(postponable);
+        used.run(F);
+        const Domain<Expression> &domain = anticipated.domain();
+        assert(domain.size() == used.domain().size() && "All analyses must share the same domain.");
+
+        // 先根据分析结果收集所有改写, 改写开始之后不再查询分析结果
+        std::vector<ExpressionMotion> motions(domain.size());
+        for (BasicBlock &bb : F) {
+            BitSet latest = postponable.Latest(bb);
+            BitSet used_out = used.BlockOut(bb);
+            BitSet placements = latest;
+            placements &= used_out;
+            BitSet saved(domain.size());
+            for (Instruction &inst : bb) {
+                if (!Expression::IsExpression(inst)) {
+                    continue;
+                }
+                unsigned expr_idx = domain.position(Expression(inst));
+                ExpressionMotion &motion = motions[expr_idx];
+                if (motion.instance == nullptr) {
+                    motion.instance = &inst;
+                }
+                if (!IsUpwardExposed(inst) || placements.test(expr_idx)) {
+                    // 在操作数定值之后计算, 或者本来就应该在这个基本块的入口处放置(之前没有任何指令需要它的值),
+                    // 之后还会被使用时把第一次计算的结果保存到临时变量, 其余的计算读取临时变量
+                    if (!used_out.test(expr_idx)) {
+                        continue;
+                    }
+                    if (!saved.test(expr_idx)) {
+                        motion.saves.push_back(&inst);
+                        saved.set(expr_idx);
+                    } else {
+                        motion.redundancies.push_back(&inst);
+                    }
+                } else if (!latest.test(expr_idx)) {
+                    // 放置在latest但之后不再使用时保留原来的计算, 否则改为读取临时变量
+                    motion.redundancies.push_back(&inst);
+                }
+            }
+            placements.reset(saved);
+            for (unsigned expr_idx : placements.set_bits()) {
+                motions[expr_idx].placements.push_back(&bb);
+            }
+        }
+        anticipated.release();
+        available.release();
+        postponable.release();
+        used.release();
+
+        // 可能触发异常的表达式(例如除数不是常量的除法)在被提前计算的路径上可能没有机会执行, 不为它们放置新的计算;
+        // 没有placement时只是把完全冗余的计算改为读取之前保存的结果, 不会提前计算, 仍然可以改写
+        std::vector<AllocaInst *> temporaries(domain.size(), nullptr);
+        std::vector<AllocaInst *> allocas;
+        const DataLayout &DL = F.getParent()->getDataLayout();
+        Instruction *alloca_pos = &*F.getEntryBlock().getFirstInsertionPt();
+        for (unsigned expr_idx = 0; expr_idx < domain.size(); ++expr_idx) {
+            const ExpressionMotion &motion = motions[expr_idx];
+            if (motion.redundancies.empty()
+                || (!motion.placements.empty() && !isSafeToSpeculativelyExecute(motion.instance))) {
+                continue;
+            }
+            temporaries[expr_idx] = new AllocaInst(motion.instance->getType(), DL.getAllocaAddrSpace(),
+                                                   motion.instance->getName() + ".lcm", alloca_pos);
+            allocas.push_back(temporaries[expr_idx]);
+        }
+        if (allocas.empty()) {
+            changed |= !MergeSplitBlocks(F, original_blocks);
+            return changed;
+        }
+
+        // 插入的计算直接引用原来的操作数, 所以要在替换任何计算之前完成; 操作数之后被替换为读取临时变量时,
+        // load位于原来的计算所在的位置, 仍然支配插入的计算
+        unsigned num_inserted = 0, num_replaced = 0;
+        for (unsigned expr_idx = 0; expr_idx < domain.size(); ++expr_idx) {
+            AllocaInst *temporary = temporaries[expr_idx];
+            if (temporary == nullptr) {
+                continue;
+            }
+            const ExpressionMotion &motion = motions[expr_idx];
+            for (BasicBlock *bb : motion.placements) {
+                Instruction *copy = motion.instance->clone();
+                // 原来的各个计算上的nsw/exact/inbounds等标志不一定相同, 提前计算的值不能比其中任何一个更容易是poison
+                copy->dropPoisonGeneratingFlags();
+                copy->setName(motion.instance->getName());
+                copy->insertBefore(&*bb->getFirstInsertionPt());
+                new StoreInst(copy, temporary, copy->getNextNode());
+                ++num_inserted;
+            }
+            for (Instruction *inst : motion.saves) {
+                inst->dropPoisonGeneratingFlags();
+                new StoreInst(inst, temporary, inst->getNextNode());
+            }
+        }
+        for (unsigned expr_idx = 0; expr_idx < domain.size(); ++expr_idx) {
+            AllocaInst *temporary = temporaries[expr_idx];
+            if (temporary == nullptr) {
+                continue;
+            }
+            for (Instruction *inst : motions[expr_idx].redundancies) {
+                auto *load = new LoadInst(inst->getType(), temporary, inst->getName(), inst);
+                inst->replaceAllUsesWith(load);
+                inst->eraseFromParent();
+                ++num_replaced;
+            }
+        }
+
+        DominatorTree dom_tree(F);
+        PromoteMemToReg(allocas, dom_tree);
+        MergeSplitBlocks(F, original_blocks);
+
+        NumInserted += num_inserted;
+        NumReplaced += num_replaced;
+        return true;
+    }
+
+    PreservedAnalyses LazyCodeMotionPass::run(Function &F, FunctionAnalysisManager &) {
+        return RunLazyCodeMotion(F) ? PreservedAnalyses::none() : PreservedAnalyses::all();
+    }
+}
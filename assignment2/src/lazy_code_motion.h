@@ -0,0 +1,118 @@
+//
+// Created by sakura on 2026/10/17.
+//
+
+#ifndef ASSIGNMENT2_LAZY_CODE_MOTION_H
+#define ASSIGNMENT2_LAZY_CODE_MOTION_H
+
+#include <llvm/IR/Function.h>
+#include <llvm/IR/PassManager.h>
+#include "avail_expr.h"
+
+namespace dfa {
+    /// Anticipated (Very Busy) Expressions
+    ///
+    /// 后向, meet operator为交集: 表达式在某点被anticipate, 当且仅当从该点出发的每条路径
+    /// 都会在它的操作数被重新定值之前计算它, 即在该点计算它是安全的(不会在任何路径上多计算一次).
+    class AnticipatedExpr final : public ExpressionFramework<AnticipatedExpr, Direction::Backward, Intersection> {
+        typedef ExpressionFramework<AnticipatedExpr, Direction::Backward, Intersection> base_t;
+        friend base_t;
+        friend base_t::framework_t;
+    protected:
+        BitSet IC() const;
+
+        BitSet BC() const;
+
+        void GenKill(const Instruction &inst, BitSet &gen, BitSet &kill) const;
+    };
+
+    /// Will-be-Available Expressions
+    ///
+    /// 前向, meet operator为交集: 假设在每个基本块的入口处都计算了在那里被anticipate的表达式, 表达式是否可用.
+    /// 与dfa::AvailExpr的区别只在于每个基本块的入口处额外gen该处被anticipate的表达式.
+    class WillBeAvailExpr final : public ExpressionFramework<WillBeAvailExpr, Direction::Forward, Intersection> {
+        typedef ExpressionFramework<WillBeAvailExpr, Direction::Forward, Intersection> base_t;
+        friend base_t;
+        friend base_t::framework_t;
+    private:
+        const AnticipatedExpr &_anticipated;
+    protected:
+        BitSet IC() const;
+
+        BitSet BC() const;
+
+        void GenKill(const Instruction &inst, BitSet &gen, BitSet &kill) const;
+
+    public:
+        /// @param anticipated 同一个函数上已经run()过的anticipated expressions
+        explicit WillBeAvailExpr(const AnticipatedExpr &anticipated) : _anticipated(anticipated) {}
+    };
+
+    /// Postponable Expressions
+    ///
+    /// 前向, meet operator为交集: 表达式的计算最早可以放在earliest[B] = anticipated.in[B] - available.in[B],
+    /// 在遇到对它的使用之前, 沿着每条路径都可以把它推迟. 推迟到不能再推迟的位置(latest)计算, 临时变量的活跃区间最短.
+    class PostponableExpr final : public ExpressionFramework<PostponableExpr, Direction::Forward, Intersection> {
+        typedef ExpressionFramework<PostponableExpr, Direction::Forward, Intersection> base_t;
+        friend base_t;
+        friend base_t::framework_t;
+    private:
+        const AnticipatedExpr &_anticipated;
+        const WillBeAvailExpr &_available;
+    protected:
+        BitSet IC() const;
+
+        BitSet BC() const;
+
+        void GenKill(const Instruction &inst, BitSet &gen, BitSet &kill) const;
+
+    public:
+        /// @param anticipated, available 同一个函数上已经run()过的两个分析
+        PostponableExpr(const AnticipatedExpr &anticipated, const WillBeAvailExpr &available)
+                : _anticipated(anticipated), _available(available) {}
+
+        /// @brief 基本块@p bb 中在入口处之前没有被重新定值的表达式, 即e_use[B]
+        BitSet UpwardExposed(const BasicBlock &bb) const;
+
+        /// @brief 表达式在基本块@p bb 的入口处最早可以被放置的集合
+        BitSet Earliest(const BasicBlock &bb) const;
+
+        /// @brief  表达式在基本块@p bb 的入口处必须被放置的集合:
+        ///         latest[B] = (earliest[B] ∪ postponable.in[B]) ∩
+        ///                     (e_use[B] ∪ ¬(∩_{S ∈ succ(B)} (earliest[S] ∪ postponable.in[S])))
+        BitSet Latest(const BasicBlock &bb) const;
+    };
+
+    /// Used Expressions
+    ///
+    /// 后向, meet operator为并集: 在latest处放置的临时变量之后是否还会被使用,
+    /// 只有之后还会被使用时才需要把表达式的值保存到临时变量中.
+    class UsedExpr final : public ExpressionFramework<UsedExpr, Direction::Backward, Union> {
+        typedef ExpressionFramework<UsedExpr, Direction::Backward, Union> base_t;
+        friend base_t;
+        friend base_t::framework_t;
+    private:
+        const PostponableExpr &_postponable;
+    protected:
+        BitSet IC() const;
+
+        BitSet BC() const;
+
+        void GenKill(const Instruction &inst, BitSet &gen, BitSet &kill) const;
+
+    public:
+        /// @param postponable 同一个函数上已经run()过的postponable expressions
+        explicit UsedExpr(const PostponableExpr &postponable) : _postponable(postponable) {}
+    };
+
+    /// @brief  对@p F 运行lazy code motion(partial redundancy elimination): 在latest处插入表达式的计算,
+    ///         删除被它们覆盖的冗余计算. 会拆分critical edge, 返回IR是否改变
+    bool RunLazyCodeMotion(llvm::Function &F);
+
+    /// New-PM Lazy Code Motion Pass
+    class LazyCodeMotionPass : public llvm::PassInfoMixin<LazyCodeMotionPass> {
+    public:
+        llvm::PreservedAnalyses run(llvm::Function &F, llvm::FunctionAnalysisManager &);
+    };
+}
+#endif //ASSIGNMENT2_LAZY_CODE_MOTION_H
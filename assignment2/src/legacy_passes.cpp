@@ -0,0 +1,26 @@
+//
+// Created by sakura on 2026/10/17.
+//
+
+// 旧pass manager下liveness一族的打印pass:
+//   opt -load libAssignment2.so -liveness input.ll -o /dev/null
+//   opt -load libAssignment2.so -liveness-ssa input.ll -o /dev/null
+//   opt -load libAssignment2.so -register-pressure input.ll -o /dev/null
+// 分析本身(liveness.cpp, register_pressure.cpp)不注册任何东西, assignment3直接把它们编译进去使用,
+// 注册只放在这里, 两个插件可以同时加载.
+
+#include "liveness.h"
+#include "register_pressure.h"
+
+using namespace llvm;
+
+namespace {
+    RegisterPass<dfa::LegacyPrinterPass<dfa::Liveness>> X(
+            "liveness", "Liveness");
+
+    RegisterPass<dfa::LegacyPrinterPass<dfa::SSALiveness>> Y(
+            "liveness-ssa", "Liveness (SSA path exploration)");
+
+    RegisterPass<dfa::LegacyPrinterPass<dfa::RegisterPressure>> Z(
+            "register-pressure", "Register Pressure and Live Intervals (from Liveness)");
+} // namespace anonymous
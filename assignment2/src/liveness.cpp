@@ -32,151 +32,309 @@
     // instr1 :
     // input1 = IC = ∅
 
-#include "framework.h"
+#include "liveness.h"
 
 using namespace llvm;
+using dfa::Variable;
 
 namespace {
-    class Variable {
-    private:
-        const Value *_value;
-    public:
-        explicit Variable(const Value *value) : _value(value) {}
-
-        bool operator==(const Variable &variable) const {
-            return _value == variable._value;
+    /// @brief 对边(@p succ_bb -> @p bb)上需要kill掉的每个值调用@p fn :
+    ///        @p succ_bb 中的phi指令从@p bb 以外的前驱流入的值, 它们沿着这条边并不活跃.
+    template<class TFn>
+    void ForEachPhiEdgeKill(const BasicBlock &succ_bb, const BasicBlock &bb, TFn fn) {
+        // 当前处理的后继块遍历所有phi指令
+        for (const PHINode &phi : succ_bb.phis()) {
+            //遍历当前后继基本块里的phi指令所有可能的前驱基本块
+            for (const BasicBlock *phi_pred_bb_ptr : phi.blocks()) {
+                //如果当前前驱基本块不是现在的基本块, 则从它流入的值沿这条边被kill
+                if (phi_pred_bb_ptr != &bb) {
+                    fn(phi.getIncomingValueForBlock(phi_pred_bb_ptr));
+                }
+            }
         }
+    }
 
-        const Value *getValue() const {
-            return _value;
+    /// @brief 把指令@p inst 中属于活跃变量domain的操作数(指令和函数参数)加入@p domain
+    void AddVariableOperands(const Instruction &inst, dfa::Domain<Variable> &domain) {
+        for (const Use &op : inst.operands()) {
+            if (isa<Instruction>(op) || isa<Argument>(op)) {
+                domain.emplace(Variable(op));
+            }
         }
-
-        friend raw_ostream &operator<<(raw_ostream &outs, const Variable &var);
-    };
-
-    raw_ostream &operator<<(raw_ostream &outs, const Variable &var) {
-        outs << "[";
-        var._value->printAsOperand(outs, false);
-        outs << "]";
-        return outs;
     }
-}// namespace anonymous
-
-namespace std {
-
-// Construct a hash code for 'Expression'.
-    template<>
-    struct hash<Variable> {
-        std::size_t operator()(const Variable &var) const {
-            std::hash<const Value *> pvalue_hasher;
 
-            std::size_t value_hash = pvalue_hasher((var.getValue()));
+    /// @brief 变量@p val 的定义所在的基本块, 函数参数定义在entry之前, 返回nullptr
+    const BasicBlock *DefBlock(const Value *val) {
+        if (const auto *inst = dyn_cast<Instruction>(val)) {
+            return inst->getParent();
+        }
+        return nullptr;
+    }
 
-            return value_hash;
+    /// @brief 指令@p user 对变量@p val 的use在基本块内是否向上暴露, 即在同一基本块内@p val 的定义之前
+    bool IsUpwardExposed(const Instruction &user, const Value *val) {
+        const auto *def = dyn_cast<Instruction>(val);
+        if (def == nullptr || def->getParent() != user.getParent()) {
+            return true;
         }
-    };
+        // 指令使用自己的定义(只可能是phi)时, gen - kill为空, 不算向上暴露
+        return &user != def && user.comesBefore(def);
+    }
+} // namespace anonymous
 
-}  // namespace std
+namespace dfa {
+    Liveness::set_t Liveness::IC() const {
+        return set_t(_domain.size());
+    }
 
-namespace {
-    class Liveness final : public dfa::Framework<Variable, dfa::Direction::Backward> {
-    protected:
-        virtual BitVector IC() const override {
-            return BitVector(_domain.size());
-        }
-
-        virtual BitVector BC() const override {
-            return BitVector(_domain.size());
-        }
-
-        // 仅实现，不使用
-        virtual BitVector MeetOp(const meetop_const_range &meet_operands) const override {
-            // U In[S]
-            BitVector result(_domain.size(), false);
-            return result;
-        }
-
-        virtual BitVector MeetOp(const BasicBlock &bb) const override {
-            BitVector result(_domain.size(), false);
-            for (const BasicBlock *succ_bb_ptr : successors(&bb)) {
-                //所有后继基本块的第一条Instr的IN集合的并集，就是当前基本块的OUT集
-                BitVector succ_bv = _inst_bv_map.at(&succ_bb_ptr->front());
-                // 对含有phi指令的基础块作特殊处理，因为phi指令涉及到的变量需要来自于我们要处理的块才是活跃的
-                // 当前处理的后继块遍历所有phi指令
-                for (const PHINode &phi : succ_bb_ptr->phis()) {
-                    //遍历当前后继基本块里的phi指令所有可能的前驱基本块
-                    for (const BasicBlock *phi_pred_bb_ptr : phi.blocks()) {
-                        //如果当前前驱基本块不是现在的基本块
-                        if (phi_pred_bb_ptr != &bb) {
-                            //得到该基本块中定义的变量
-                            const Value *val = phi.getIncomingValueForBlock(phi_pred_bb_ptr);
-                            //如果该变量在domain中存在，将该变量在IN集合中的状态设置为false
-                            int idx = position(Variable(val));
-                            if (idx != -1) {
-                                // 将临时变量中对应变量的bit设置为false
-                                assert(succ_bv[idx] = true);
-                                succ_bv[idx] = false;
-                            }
-                        }
-                    }
-                }
-                result |= succ_bv;
+    Liveness::set_t Liveness::BC() const {
+        return set_t(_domain.size());
+    }
+
+    // 所有后继基本块的第一条Instr的IN集合的并集，就是当前基本块的OUT集 (meet operator为dfa::Union)
+    // 对含有phi指令的基础块作特殊处理，因为phi指令涉及到的变量需要来自于我们要处理的块才是活跃的,
+    // 所以边(succ_bb -> bb)上要kill掉从其他前驱流入phi的变量. 这个kill只取决于CFG, 框架在求解前对每条边只计算一次
+    void Liveness::EdgeKill(const BasicBlock &succ_bb, const BasicBlock &bb, set_t &edge_kill) const {
+        ForEachPhiEdgeKill(succ_bb, bb, [&](const Value *val) {
+            //如果该变量在domain中存在，沿这条边kill掉该变量
+            int idx = position(Variable(val));
+            if (idx != -1) {
+                edge_kill.set(idx);
             }
-            return result;
-        }
+        });
+    }
 
-        virtual bool TransferFunc(const Instruction &inst,
-                                  const BitVector &ibv,
-                                  BitVector &obv) override {
-            // use U (In - def)
-            bool hasChanges;
-            BitVector temp_obv = ibv;
-//            // use
+    void Liveness::GenKill(const Instruction &inst,
+                           set_t &gen,
+                           set_t &kill) const {
+        // use U (In - def)
+//        // use
+        // faint指令的use不使操作数活跃, 但它的def仍然kill
+        if (_faint == nullptr || _faint->count(&inst) == 0) {
             for (auto &op : inst.operands()) {
 //                //如果变量在domain中
                 const Value *op_val = dyn_cast<Value>(op.get());
                 assert(op_val != NULL);
                 int use_idx = position(Variable(op_val));
                 if (use_idx != -1) {
-                    temp_obv[use_idx] = true;
+                    gen.set(use_idx);
                 }
             }
-//            // def
-            const Value *inst_op = dyn_cast<Value>(&inst);
-            assert(inst_op != NULL);
-            int def_idx = position(Variable(inst_op));
-            if (def_idx != -1) {
-                temp_obv[def_idx] = false;
+        }
+//        // def
+        const Value *inst_op = dyn_cast<Value>(&inst);
+        assert(inst_op != NULL);
+        int def_idx = position(Variable(inst_op));
+        if (def_idx != -1) {
+            kill.set(def_idx);
+        }
+    }
+
+    void Liveness::InitializeDomainFromInstruction(const Instruction &inst) {
+        AddVariableOperands(inst, _domain);
+    }
+
+    void SSALiveness::propagate(unsigned var_idx, const BasicBlock *def_bb, std::vector<unsigned> &worklist) {
+        while (!worklist.empty()) {
+            unsigned bb_idx = worklist.back();
+            worklist.pop_back();
+            ++_num_visits;
+            unsigned edge_idx = _cfg.predBegin(bb_idx);
+            for (unsigned pred_idx : _cfg.preds(bb_idx)) {
+                // phi从其他前驱流入的值沿这条边不活跃
+                if (_edge_kill[edge_idx++].test(var_idx) || _live_out[pred_idx].test(var_idx)) {
+                    continue;
+                }
+                _live_out[pred_idx].set(var_idx);
+                // 到达定义所在的基本块就停止
+                if (_cfg.block(pred_idx) != def_bb && !_live_in[pred_idx].test(var_idx)) {
+                    _live_in[pred_idx].set(var_idx);
+                    worklist.push_back(pred_idx);
+                }
             }
-            //如果和obv不相等
-            hasChanges = temp_obv != obv;
-            obv = temp_obv;
-            return hasChanges;
         }
+    }
 
+    void SSALiveness::computeVariable(unsigned var_idx, const Value *val, std::vector<unsigned> &worklist) {
+        const BasicBlock *def_bb = DefBlock(val);
+        for (const User *user : val->users()) {
+            const auto *user_inst = dyn_cast<Instruction>(user);
+            if (user_inst == nullptr || !IsUpwardExposed(*user_inst, val)) {
+                continue;
+            }
+            unsigned bb_idx = _cfg.index(*user_inst->getParent());
+            if (!_live_in[bb_idx].test(var_idx)) {
+                _live_in[bb_idx].set(var_idx);
+                worklist.push_back(bb_idx);
+            }
+        }
+        propagate(var_idx, def_bb, worklist);
+    }
 
-        virtual void InitializeDomainFromInstruction(const Instruction &inst)
-        override {
-            for (const Use &op : inst.operands()) {
-                if (isa<Instruction>(op) || isa<Argument>(op)) {
-                    _domain.emplace(Variable(op));
+    void SSALiveness::materializeBlock(unsigned bb_idx, std::vector<set_t> &inst_bvs) const {
+        ArrayRef<const Instruction *> insts = _cfg.insts(bb_idx);
+        inst_bvs.resize(insts.size());
+        set_t bv = _live_out[bb_idx];
+        for (unsigned pos = insts.size(); pos-- > 0;) {
+            const Instruction *inst = insts[pos];
+            int def_idx = _domain.position(Variable(inst));
+            if (def_idx != -1) {
+                bv.reset(def_idx);
+            }
+            for (const Use &op : inst->operands()) {
+                int use_idx = _domain.position(Variable(op.get()));
+                if (use_idx != -1 && use_idx != def_idx) {
+                    bv.set(use_idx);
                 }
             }
+            inst_bvs[pos] = bv;
         }
+    }
 
-    public:
-        static char ID;
+    void SSALiveness::run(const Function &F) {
+        release();
+        for (const Instruction &inst : instructions(F)) {
+            AddVariableOperands(inst, _domain);
+        }
+        std::vector<const BasicBlock *> order;
+        for (const BasicBlock &bb : F) {
+            order.push_back(&bb);
+        }
+        _cfg.build(order);
+        // recalculate只读取CFG, 不修改函数
+        _dom_tree.recalculate(const_cast<Function &>(F));
+        _live_in.assign(_cfg.size(), set_t(_domain.size()));
+        _live_out.assign(_cfg.size(), set_t(_domain.size()));
+        // 每条入边上的kill只取决于CFG, 只有含phi的基本块的入边才非空
+        _edge_kill.assign(_cfg.numEdges(), set_t(_domain.size()));
+        for (unsigned bb_idx = 0; bb_idx < _cfg.size(); ++bb_idx) {
+            unsigned edge_idx = _cfg.predBegin(bb_idx);
+            for (unsigned pred_idx : _cfg.preds(bb_idx)) {
+                set_t &edge_kill = _edge_kill[edge_idx++];
+                ForEachPhiEdgeKill(*_cfg.block(bb_idx), *_cfg.block(pred_idx), [&](const Value *val) {
+                    int idx = _domain.position(Variable(val));
+                    if (idx != -1) {
+                        edge_kill.set(idx);
+                    }
+                });
+            }
+        }
+        // 变量之间相互独立, 逐个变量沿def-use chain向上标记
+        std::vector<unsigned> worklist;
+        for (unsigned var_idx = 0; var_idx < _domain.size(); ++var_idx) {
+            computeVariable(var_idx, _domain[var_idx].getValue(), worklist);
+        }
+    }
 
-        Liveness() : dfa::Framework<domain_element_t,
-                direction_c>(ID) {}
+    void SSALiveness::release() {
+        _domain.clear();
+        _live_in.clear();
+        _live_out.clear();
+        _edge_kill.clear();
+        _dom_tree.reset();
+        _num_visits = 0;
+    }
 
-        virtual ~Liveness()
-        override {}
+    bool SSALiveness::query(const std::vector<set_t> &live, const Value *val, const BasicBlock &bb) const {
+        int var_idx = _domain.position(Variable(val));
+        if (var_idx == -1) {
+            return false;
+        }
+        // 严格SSA中变量只可能在其定义所在基本块支配的(可达)基本块中活跃
+        const BasicBlock *def_bb = DefBlock(val);
+        if (def_bb != nullptr && _dom_tree.isReachableFromEntry(&bb) && !_dom_tree.dominates(def_bb, &bb)) {
+            return false;
+        }
+        return live[_cfg.index(bb)].test(var_idx);
+    }
 
-    };
+    void SSALiveness::printDomainWithMask(const set_t &mask, raw_ostream &os) const {
+        os << "{";
+        for (unsigned mask_idx : mask.set_bits()) {
+            os << _domain[mask_idx] << ",";
+        }
+        os << "}";
+    }
 
-    char Liveness::ID = 1;
-    RegisterPass<Liveness> Y(
-            "liveness", "Liveness");
+    void SSALiveness::printInstBVMap(const Function &F, raw_ostream &os) const {
+        os << "********************************************" << "\n";
+        os << "* Instruction-BitVector Mapping             " << "\n";
+        os << "********************************************" << "\n";
+        std::vector<set_t> inst_bvs;
+        for (const BasicBlock &bb : F) {
+            unsigned bb_idx = _cfg.index(bb);
+            materializeBlock(bb_idx, inst_bvs);
+            // 没有后继的基本块位于边界
+            os << (_cfg.succs(bb_idx).empty() ? "BC:\t" : "MeetOp:\t");
+            printDomainWithMask(_live_out[bb_idx], os);
+            os << "\n";
+            unsigned inst_idx = 0;
+            for (const Instruction &inst : bb) {
+                os << "Instruction: " << inst << "\n";
+                os << "\t";
+                printDomainWithMask(inst_bvs[inst_idx++], os);
+                os << "\n";
+            }
+        }
+    }
 
-} // namespace anonymous
\ No newline at end of file
+    void SSALiveness::writeResults(const Function &F, OutputFormat format, ResultWriter &writer) const {
+        std::vector<set_t> inst_bvs;
+        if (format == OutputFormat::Binary) {
+            writer.write("DFA1");
+            writer.writeBytes(F.getName());
+            writer.writeU32(_domain.size());
+            for (unsigned elem_idx = 0; elem_idx < _domain.size(); ++elem_idx) {
+                writer.writeBytes(ToString(_domain[elem_idx]));
+            }
+            writer.writeU32(F.size());
+            unsigned num_words = (_domain.size() + 63) / 64;
+            std::vector<uint64_t> words;
+            auto write_row = [&](const set_t &bv) {
+                words.assign(num_words, 0);
+                for (unsigned idx : bv.set_bits()) {
+                    words[idx / 64] |= uint64_t(1) << (idx % 64);
+                }
+                for (uint64_t word : words) {
+                    writer.writeU64(word);
+                }
+            };
+            for (const BasicBlock &bb : F) {
+                unsigned bb_idx = _cfg.index(bb);
+                materializeBlock(bb_idx, inst_bvs);
+                writer.writeU32(inst_bvs.size());
+                write_row(_live_out[bb_idx]);
+                for (const set_t &inst_bv : inst_bvs) {
+                    write_row(inst_bv);
+                }
+            }
+            return;
+        }
+        assert(format == OutputFormat::JSONL && "Only Binary and JSONL are structured formats.");
+        writer.write("{\"function\":");
+        writer.writeJSONString(F.getName());
+        writer.write(",\"domain\":[");
+        for (unsigned elem_idx = 0; elem_idx < _domain.size(); ++elem_idx) {
+            if (elem_idx != 0) {
+                writer.write(',');
+            }
+            writer.writeJSONString(ToString(_domain[elem_idx]));
+        }
+        writer.write("],\"blocks\":[");
+        for (const BasicBlock &bb : F) {
+            unsigned bb_idx = _cfg.index(bb);
+            materializeBlock(bb_idx, inst_bvs);
+            writer.write(&bb == &F.front() ? "{\"input\":" : ",{\"input\":");
+            writer.writeJSONArray(_live_out[bb_idx].set_bits());
+            writer.write(",\"insts\":[");
+            for (unsigned inst_idx = 0; inst_idx < inst_bvs.size(); ++inst_idx) {
+                if (inst_idx != 0) {
+                    writer.write(',');
+                }
+                writer.writeJSONArray(inst_bvs[inst_idx].set_bits());
+            }
+            writer.write("]}");
+        }
+        writer.write("]}\n");
+    }
+} // namespace dfa
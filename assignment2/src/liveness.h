@@ -0,0 +1,193 @@
+//
+// Created by sakura on 2026/10/17.
+//
+
+#ifndef ASSIGNMENT2_LIVENESS_H
+#define ASSIGNMENT2_LIVENESS_H
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include <llvm/ADT/DenseSet.h>
+#include <llvm/IR/Dominators.h>
+#include <llvm/IR/Value.h>
+#include <llvm/Support/raw_ostream.h>
+#include "analysis.h"
+#include "framework.h"
+
+namespace dfa {
+    class Variable {
+    private:
+        const Value *_value;
+    public:
+        explicit Variable(const Value *value) : _value(value) {}
+
+        bool operator==(const Variable &variable) const {
+            return _value == variable._value;
+        }
+
+        const Value *getValue() const {
+            return _value;
+        }
+
+        friend raw_ostream &operator<<(raw_ostream &outs, const Variable &var) {
+            outs << "[";
+            var._value->printAsOperand(outs, false);
+            outs << "]";
+            return outs;
+        }
+    };
+}// namespace dfa
+
+namespace std {
+
+// Construct a hash code for 'Variable'.
+    template<>
+    struct hash<dfa::Variable> {
+        std::size_t operator()(const dfa::Variable &var) const {
+            std::hash<const Value *> pvalue_hasher;
+
+            std::size_t value_hash = pvalue_hasher((var.getValue()));
+
+            return value_hash;
+        }
+    };
+
+}  // namespace std
+
+namespace dfa {
+    /// Liveness
+    ///
+    /// 后向, meet operator为并集. 活跃变量通常只占domain中很小的一部分,
+    /// 所以state使用AdaptiveBitSet, 内存随活跃变量的个数增长.
+    /// 求解完成后可以按基本块或指令查询某个变量是否活跃, 不在domain中的值总是不活跃.
+    ///
+    /// 设置了faint指令集合时求解的是faint variables的补集(strong liveness): 集合中的指令被看作已经删除,
+    /// 它们对操作数的use不使操作数活跃, 所以只被无用的计算使用的变量不活跃.
+    class Liveness final
+            : public Framework<Liveness, Variable, Direction::Backward, Union, AdaptiveBitSet> {
+        typedef Framework<Liveness, Variable, Direction::Backward, Union, AdaptiveBitSet> base_t;
+        friend base_t;
+    private:
+        const DenseSet<const Instruction *> *_faint = nullptr;
+    protected:
+        set_t IC() const;
+
+        set_t BC() const;
+
+        void EdgeKill(const BasicBlock &succ_bb, const BasicBlock &bb, set_t &edge_kill) const;
+
+        void GenKill(const Instruction &inst, set_t &gen, set_t &kill) const;
+
+        void InitializeDomainFromInstruction(const Instruction &inst);
+
+    public:
+        /// @brief  之后的run()把@p faint 中的指令看作已经被删除, 传入nullptr恢复普通的liveness.
+        ///         集合在两次run()之间改变时, 对改变的指令调用transferChanged()之后可以增量地update()
+        void setFaintInstructions(const DenseSet<const Instruction *> *faint) {
+            _faint = faint;
+        }
+
+        /// @brief 变量@p val 在基本块@p bb 的入口处是否活跃
+        bool isLiveIn(const Value *val, const BasicBlock &bb) const {
+            int var_idx = position(Variable(val));
+            // 后向分析中基本块的state就是入口处的state, 不需要重新meet
+            return var_idx != -1 && BlockBV(bb).test(var_idx);
+        }
+
+        /// @brief 变量@p val 在基本块@p bb 的出口处是否活跃
+        bool isLiveOut(const Value *val, const BasicBlock &bb) const {
+            int var_idx = position(Variable(val));
+            return var_idx != -1 && BlockOut(bb).test(var_idx);
+        }
+
+        /// @brief 变量@p val 在指令@p inst 之前是否活跃
+        bool isLiveBefore(const Value *val, const Instruction &inst) const {
+            int var_idx = position(Variable(val));
+            return var_idx != -1 && InstIn(inst).test(var_idx);
+        }
+
+        /// @brief 变量@p val 在指令@p inst 之后是否活跃
+        bool isLiveAfter(const Value *val, const Instruction &inst) const {
+            int var_idx = position(Variable(val));
+            return var_idx != -1 && InstOut(inst).test(var_idx);
+        }
+    };
+
+    /// @brief 新pass manager下的liveness analysis, 结果为缓存的dfa::Liveness
+    typedef AnalysisPass<Liveness> LivenessAnalysis;
+
+    /// SSA Liveness
+    ///
+    /// 与Liveness给出相同结果的另一个引擎: 不在整个函数的bitvector上迭代到不动点, 而是利用SSA的性质,
+    /// 对每个变量沿着def-use chain从它的每个use出发向上(逆着CFG边)标记, 直到遇到它的定义所在的基本块.
+    /// 变量之间互不影响, 所以每个基本块只会被同一个变量访问一次, 总的代价与活跃区间的大小成正比.
+    /// 在严格SSA中定义所在的基本块支配所有活跃的基本块, 因此查询时可以先用支配树排除.
+    ///
+    /// 结果按基本块保存live-in/live-out, 每条指令的state在输出时从live-out逐条指令重建,
+    /// phi的处理与Liveness完全相同, domain的编号和输出格式(包括-dfa-output的各种格式)也相同, 两者可以直接diff.
+    /// 提供与数据流求解器相同的接口, 调用者可以按函数选择其中一个引擎.
+    class SSALiveness {
+    private:
+        typedef SparseBitSet set_t;
+
+        Domain<Variable> _domain;
+        // 基本块按布局顺序编号
+        CFGSnapshot _cfg;
+        // 每个基本块入口/出口处活跃的变量
+        std::vector<set_t> _live_in, _live_out;
+        // 每条入边上被phi kill掉的变量, 以边在_cfg.preds中的编号为下标
+        std::vector<set_t> _edge_kill;
+        DominatorTree _dom_tree;
+        // 上一次run()中基本块被某个变量访问的次数
+        uint64_t _num_visits = 0;
+
+        /// @brief 沿着入边向上传播编号为@p var_idx 的变量的活跃性, 直到定义所在的基本块@p def_bb
+        void propagate(unsigned var_idx, const BasicBlock *def_bb, std::vector<unsigned> &worklist);
+
+        /// @brief 从变量@p val 的所有use出发, 计算它在每个基本块入口/出口处是否活跃
+        void computeVariable(unsigned var_idx, const Value *val, std::vector<unsigned> &worklist);
+
+        /// @brief 逆序遍历基本块@p bb_idx 的指令, 从live-out重建每条指令之前的state, 按布局顺序写入@p inst_bvs
+        void materializeBlock(unsigned bb_idx, std::vector<set_t> &inst_bvs) const;
+
+        void printDomainWithMask(const set_t &mask, raw_ostream &os) const;
+
+        bool query(const std::vector<set_t> &live, const Value *val, const BasicBlock &bb) const;
+
+    public:
+        /// @brief 求解器的选项对这个引擎没有影响, 只是为了可以与Framework的子类一样被包装成pass
+        void setOptions(const SolverOptions &) {}
+
+        /// @brief 上一次run()中基本块被访问的次数, 对应Framework中传递函数的求值次数
+        uint64_t numTransferEvaluations() const { return _num_visits; }
+
+        /// @brief 求解函数@p F , 结果一直保留到下一次run()或release()
+        void run(const Function &F);
+
+        void release();
+
+        const Domain<Variable> &domain() const { return _domain; }
+
+        /// @brief 变量@p val 在基本块@p bb 的入口处是否活跃
+        bool isLiveIn(const Value *val, const BasicBlock &bb) const {
+            return query(_live_in, val, bb);
+        }
+
+        /// @brief 变量@p val 在基本块@p bb 的出口处是否活跃
+        bool isLiveOut(const Value *val, const BasicBlock &bb) const {
+            return query(_live_out, val, bb);
+        }
+
+        /// @brief 与Liveness::printInstBVMap相同的格式
+        void printInstBVMap(const Function &F, raw_ostream &os) const;
+
+        /// @brief 与Liveness::writeResults相同的格式
+        void writeResults(const Function &F, OutputFormat format, ResultWriter &writer) const;
+    };
+
+    /// @brief 新pass manager下的SSA liveness analysis, 结果为缓存的dfa::SSALiveness
+    typedef AnalysisPass<SSALiveness> SSALivenessAnalysis;
+}
+#endif //ASSIGNMENT2_LIVENESS_H
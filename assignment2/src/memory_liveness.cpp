@@ -0,0 +1,120 @@
+//
+// Created by sakura on 2026/10/17.
+//
+
+#include <llvm/ADT/SmallVector.h>
+#include <llvm/IR/DataLayout.h>
+#include <llvm/IR/IntrinsicInst.h>
+#include <llvm/IR/Module.h>
+#include "memory_liveness.h"
+
+using namespace llvm;
+using dfa::MemorySlot;
+
+namespace {
+    /// @brief  收集由@p alloca 派生出的所有指针(包括它自己)写入@p derived .
+    /// @return 地址是否逃逸: 被load/store(作为地址), bitcast/GEP, lifetime intrinsic以外的指令使用
+    bool CollectDerivedPointers(const AllocaInst &alloca, SmallVectorImpl<const Value *> &derived) {
+        derived.push_back(&alloca);
+        // bitcast/GEP的结果不会再回到phi/select(否则已经逃逸), 所以派生关系是一棵树
+        for (unsigned ptr_idx = 0; ptr_idx < derived.size(); ++ptr_idx) {
+            const Value *ptr = derived[ptr_idx];
+            for (const User *user : ptr->users()) {
+                if (isa<LoadInst>(user) || isa<BitCastInst>(user) || isa<GetElementPtrInst>(user)) {
+                    if (!isa<LoadInst>(user)) {
+                        derived.push_back(user);
+                    }
+                    continue;
+                }
+                // 把地址本身存入内存就逃逸了
+                if (const auto *store = dyn_cast<StoreInst>(user)) {
+                    if (store->getValueOperand() == ptr) {
+                        return true;
+                    }
+                    continue;
+                }
+                if (const auto *intrinsic = dyn_cast<IntrinsicInst>(user)) {
+                    if (intrinsic->isLifetimeStartOrEnd()) {
+                        continue;
+                    }
+                }
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /// @brief @p store 是否覆盖了整个@p alloca : 地址就是alloca的起始地址, 写入的字节数不少于alloca的大小
+    bool OverwritesSlot(const StoreInst &store, const AllocaInst &alloca) {
+        if (store.getPointerOperand()->stripPointerCasts() != &alloca) {
+            return false;
+        }
+        const DataLayout &DL = store.getModule()->getDataLayout();
+        Optional<TypeSize> alloca_size = alloca.getAllocationSizeInBits(DL);
+        TypeSize store_size = DL.getTypeStoreSizeInBits(store.getValueOperand()->getType());
+        return alloca_size.hasValue() && !alloca_size->isScalable() && !store_size.isScalable() &&
+               store_size.getFixedSize() >= alloca_size->getFixedSize();
+    }
+
+    RegisterPass<dfa::LegacyPrinterPass<dfa::MemoryLiveness>> Y(
+            "memory-liveness", "Memory Liveness (non-escaping allocas)");
+} // namespace anonymous
+
+namespace dfa {
+    MemoryLiveness::set_t MemoryLiveness::IC() const {
+        return set_t(_domain.size());
+    }
+
+    // 函数返回之后栈上的slot都不再可见
+    MemoryLiveness::set_t MemoryLiveness::BC() const {
+        return set_t(_domain.size());
+    }
+
+    void MemoryLiveness::GenKill(const Instruction &inst, set_t &gen, set_t &kill) const {
+        // 读取slot中的任何一部分都使它活跃
+        if (const auto *load = dyn_cast<LoadInst>(&inst)) {
+            auto slot_iter = _slot_of.find(load->getPointerOperand());
+            if (slot_iter != _slot_of.end()) {
+                gen.set(slot_iter->second);
+            }
+            return;
+        }
+        // 只有覆盖整个slot的store才能kill, 否则之前写入的其他部分仍然可能被读取
+        if (const auto *store = dyn_cast<StoreInst>(&inst)) {
+            auto slot_iter = _slot_of.find(store->getPointerOperand());
+            if (slot_iter != _slot_of.end() && OverwritesSlot(*store, *_domain[slot_iter->second].getAlloca())) {
+                kill.set(slot_iter->second);
+            }
+            return;
+        }
+        // lifetime.start之前和lifetime.end之后slot的内容都是未定义的
+        if (const auto *intrinsic = dyn_cast<IntrinsicInst>(&inst)) {
+            if (intrinsic->isLifetimeStartOrEnd()) {
+                auto slot_iter = _slot_of.find(intrinsic->getArgOperand(1));
+                if (slot_iter != _slot_of.end()) {
+                    kill.set(slot_iter->second);
+                }
+            }
+        }
+    }
+
+    void MemoryLiveness::InitializeDomainFromInstruction(const Instruction &inst) {
+        const auto *alloca = dyn_cast<AllocaInst>(&inst);
+        if (alloca == nullptr) {
+            return;
+        }
+        SmallVector<const Value *, 8> derived;
+        if (CollectDerivedPointers(*alloca, derived)) {
+            return;
+        }
+        unsigned slot_idx = _domain.emplace(alloca);
+        for (const Value *ptr : derived) {
+            _slot_of[ptr] = slot_idx;
+        }
+    }
+
+    void MemoryLiveness::ClearDomain() {
+        base_t::ClearDomain();
+        _slot_of.clear();
+    }
+} // namespace dfa
@@ -0,0 +1,111 @@
+//
+// Created by sakura on 2026/10/17.
+//
+
+#ifndef ASSIGNMENT2_MEMORY_LIVENESS_H
+#define ASSIGNMENT2_MEMORY_LIVENESS_H
+
+#include <functional>
+
+#include <llvm/ADT/DenseMap.h>
+#include <llvm/IR/Instructions.h>
+#include <llvm/Support/raw_ostream.h>
+#include "analysis.h"
+#include "framework.h"
+
+namespace dfa {
+    /// Memory Slot
+    ///
+    /// 一个不逃逸的alloca: 它的地址只被load/store直接使用(或者经过bitcast/GEP之后再被使用),
+    /// 没有被传给函数, 存入内存或者转换为整数, 所以只有函数内可见的load能读到它的内容.
+    class MemorySlot {
+    private:
+        const AllocaInst *_alloca;
+    public:
+        explicit MemorySlot(const AllocaInst *alloca) : _alloca(alloca) {}
+
+        bool operator==(const MemorySlot &slot) const {
+            return _alloca == slot._alloca;
+        }
+
+        const AllocaInst *getAlloca() const {
+            return _alloca;
+        }
+
+        friend raw_ostream &operator<<(raw_ostream &outs, const MemorySlot &slot) {
+            outs << "[";
+            slot._alloca->printAsOperand(outs, false);
+            outs << "]";
+            return outs;
+        }
+    };
+}// namespace dfa
+
+namespace std {
+
+// Construct a hash code for 'MemorySlot'.
+    template<>
+    struct hash<dfa::MemorySlot> {
+        std::size_t operator()(const dfa::MemorySlot &slot) const {
+            return std::hash<const AllocaInst *>()(slot.getAlloca());
+        }
+    };
+
+}  // namespace std
+
+namespace dfa {
+    /// Memory Liveness
+    ///
+    /// 后向, meet operator为并集, domain为函数中不逃逸的alloca. 一个slot在某点活跃,
+    /// 当且仅当从该点出发的某条路径会在它被完整地覆盖之前读取它. load(经过bitcast/GEP的也算)gen,
+    /// 覆盖整个slot的store以及lifetime.start/end kill, 只写入一部分(例如结构体的一个字段)的store不kill.
+    /// 函数返回之后栈上的内容不再可见, 所以边界为空集.
+    class MemoryLiveness final
+            : public Framework<MemoryLiveness, MemorySlot, Direction::Backward, Union, AdaptiveBitSet> {
+        typedef Framework<MemoryLiveness, MemorySlot, Direction::Backward, Union, AdaptiveBitSet> base_t;
+        friend base_t;
+    private:
+        // 由不逃逸的alloca派生出的指针(alloca自身, bitcast和GEP) -> 它指向的slot的编号
+        DenseMap<const Value *, unsigned> _slot_of;
+
+    protected:
+        set_t IC() const;
+
+        set_t BC() const;
+
+        void GenKill(const Instruction &inst, set_t &gen, set_t &kill) const;
+
+        void InitializeDomainFromInstruction(const Instruction &inst);
+
+        void ClearDomain();
+
+    public:
+        /// @brief 指针@p ptr 指向的不逃逸的alloca, 指向其他内存时返回nullptr
+        const AllocaInst *getSlot(const Value *ptr) const {
+            auto slot_iter = _slot_of.find(ptr);
+            return slot_iter != _slot_of.end() ? _domain[slot_iter->second].getAlloca() : nullptr;
+        }
+
+        /// @brief slot @p alloca 在基本块@p bb 的入口处是否活跃
+        bool isLiveIn(const AllocaInst *alloca, const BasicBlock &bb) const {
+            int slot_idx = position(MemorySlot(alloca));
+            return slot_idx != -1 && BlockBV(bb).test(slot_idx);
+        }
+
+        /// @brief slot @p alloca 在指令@p inst 之后是否活跃
+        bool isLiveAfter(const AllocaInst *alloca, const Instruction &inst) const {
+            int slot_idx = position(MemorySlot(alloca));
+            return slot_idx != -1 && InstOut(inst).test(slot_idx);
+        }
+
+        /// @brief 非volatile, 非atomic的@p store 写入不逃逸的alloca, 并且写入的值在被覆盖或函数返回之前不会被读取
+        bool isDeadStore(const StoreInst &store) const {
+            const AllocaInst *alloca = getSlot(store.getPointerOperand());
+            return alloca != nullptr && store.isSimple() && !isLiveAfter(alloca, store);
+        }
+    };
+
+    /// @brief 新pass manager下的memory liveness analysis, 结果为缓存的dfa::MemoryLiveness
+    typedef AnalysisPass<MemoryLiveness> MemoryLivenessAnalysis;
+}
+#endif //ASSIGNMENT2_MEMORY_LIVENESS_H
@@ -0,0 +1,163 @@
+//
+// Created by sakura on 2026/10/17.
+//
+
+#ifndef ASSIGNMENT2_OUTPUT_H
+#define ASSIGNMENT2_OUTPUT_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <llvm/ADT/StringRef.h>
+#include <llvm/Support/raw_ostream.h>
+
+namespace dfa {
+    /// @brief 数据流结果的输出格式, 由-dfa-output指定
+    enum class OutputFormat {
+        // printInstBVMap的文本, 每个程序点打印整个集合
+        Text,
+        // 只求解, 不输出
+        Off,
+        // 每个函数一条记录的bit matrix, 见Framework::writeResults
+        Binary,
+        // 每个函数一行JSON, 集合写成domain编号的数组
+        JSONL
+    };
+
+    /// @brief 由命令行(-dfa-output)指定的输出格式
+    OutputFormat OutputFormatFromCommandLine();
+
+    /// @brief 结果写入的流: 指定了-dfa-output-file时为该文件(整个进程只打开一次), 否则为@p os
+    llvm::raw_ostream &ResultStream(llvm::raw_ostream &os);
+
+    /// Result Writer
+    ///
+    /// 结构化输出的缓冲区: 所有写入先追加到一块连续的内存里, 攒够FlushThreshold字节才交给raw_ostream,
+    /// 避免每个整数, 每个括号都经过一次raw_ostream的虚调用. 析构时写出剩余的内容.
+    /// 二进制的整数一律按little endian写出, 与主机的字节序无关.
+    class ResultWriter {
+    private:
+        llvm::raw_ostream &_os;
+        std::string _buffer;
+        static constexpr size_t FlushThreshold = 1 << 20;
+
+        void flushIfFull() {
+            if (_buffer.size() >= FlushThreshold) {
+                flush();
+            }
+        }
+
+    public:
+        explicit ResultWriter(llvm::raw_ostream &os) : _os(os) {
+            _buffer.reserve(FlushThreshold);
+        }
+
+        ResultWriter(const ResultWriter &) = delete;
+
+        ResultWriter &operator=(const ResultWriter &) = delete;
+
+        ~ResultWriter() {
+            flush();
+        }
+
+        void flush() {
+            _os.write(_buffer.data(), _buffer.size());
+            _buffer.clear();
+        }
+
+        void write(char c) {
+            _buffer.push_back(c);
+            flushIfFull();
+        }
+
+        void write(llvm::StringRef str) {
+            _buffer.append(str.data(), str.size());
+            flushIfFull();
+        }
+
+        /// @brief 十进制整数
+        void writeDecimal(uint64_t value) {
+            char digits[20];
+            unsigned num = 0;
+            do {
+                digits[num++] = static_cast<char>('0' + value % 10);
+                value /= 10;
+            } while (value != 0);
+            while (num > 0) {
+                _buffer.push_back(digits[--num]);
+            }
+            flushIfFull();
+        }
+
+        void writeU32(uint32_t value) {
+            for (unsigned byte = 0; byte < 4; ++byte) {
+                _buffer.push_back(static_cast<char>(value >> (byte * 8)));
+            }
+            flushIfFull();
+        }
+
+        void writeU64(uint64_t value) {
+            for (unsigned byte = 0; byte < 8; ++byte) {
+                _buffer.push_back(static_cast<char>(value >> (byte * 8)));
+            }
+            flushIfFull();
+        }
+
+        /// @brief 二进制的字符串: u32的字节数, 之后是内容
+        void writeBytes(llvm::StringRef str) {
+            writeU32(str.size());
+            write(str);
+        }
+
+        /// @brief 加上引号并转义的JSON字符串
+        void writeJSONString(llvm::StringRef str) {
+            static const char hex_digits[] = "0123456789abcdef";
+            _buffer.push_back('"');
+            for (char c : str) {
+                unsigned char uc = static_cast<unsigned char>(c);
+                if (c == '"' || c == '\\') {
+                    _buffer.push_back('\\');
+                    _buffer.push_back(c);
+                } else if (c == '\n') {
+                    _buffer.append("\\n");
+                } else if (c == '\t') {
+                    _buffer.append("\\t");
+                } else if (uc < 0x20) {
+                    _buffer.append("\\u00");
+                    _buffer.push_back(hex_digits[uc >> 4]);
+                    _buffer.push_back(hex_digits[uc & 0xf]);
+                } else {
+                    _buffer.push_back(c);
+                }
+            }
+            _buffer.push_back('"');
+            flushIfFull();
+        }
+
+        /// @brief 整数序列@p values 写成JSON数组
+        template<class TRange>
+        void writeJSONArray(const TRange &values) {
+            write('[');
+            bool first = true;
+            for (uint64_t value : values) {
+                if (!first) {
+                    write(',');
+                }
+                first = false;
+                writeDecimal(value);
+            }
+            write(']');
+        }
+    };
+
+    /// @brief @p elem 通过operator<<打印出的字符串
+    template<class T>
+    std::string ToString(const T &elem) {
+        std::string str;
+        llvm::raw_string_ostream os(str);
+        os << elem;
+        return os.str();
+    }
+}
+#endif //ASSIGNMENT2_OUTPUT_H
@@ -0,0 +1,118 @@
+//
+// Created by sakura on 2026/10/17.
+//
+
+// 新pass manager的插件入口:
+//   opt -load-pass-plugin=libAssignment2.so -passes='print<liveness>' -disable-output input.ll
+//   opt -load-pass-plugin=libAssignment2.so -passes='print<liveness-ssa>' -disable-output input.ll
+//   opt -load-pass-plugin=libAssignment2.so -passes='print<avail-expr>' -disable-output input.ll
+//   opt -load-pass-plugin=libAssignment2.so -passes='parallel-print<liveness>' -dfa-threads=8 -disable-output input.ll
+//   opt -load-pass-plugin=libAssignment2.so -passes='print<constant-propagation>' -disable-output input.ll
+//   opt -load-pass-plugin=libAssignment2.so -passes='print<value-range>' -disable-output input.ll
+//   opt -load-pass-plugin=libAssignment2.so -passes='dfa-sccp' input.ll -S -o output.ll
+//   opt -load-pass-plugin=libAssignment2.so -passes='global-cse' input.ll -S -o output.ll
+//   opt -load-pass-plugin=libAssignment2.so -passes='lazy-code-motion' input.ll -S -o output.ll
+//   opt -load-pass-plugin=libAssignment2.so -passes='dfa-adce' input.ll -S -o output.ll
+//   opt -load-pass-plugin=libAssignment2.so -passes='print<memory-liveness>' -disable-output input.ll
+//   opt -load-pass-plugin=libAssignment2.so -passes='dfa-dse' input.ll -S -o output.ll
+//   opt -load-pass-plugin=libAssignment2.so -passes='print<register-pressure>' -disable-output input.ll
+// 其他pass可以通过FAM.getResult<dfa::LivenessAnalysis>(F)等取得缓存的结果.
+// 旧pass manager的-avail_expr/-memory-liveness仍然在各自的cpp中注册, -liveness/-liveness-ssa/-register-pressure在legacy_passes.cpp中注册.
+
+#include <llvm/Passes/PassBuilder.h>
+#include <llvm/Passes/PassPlugin.h>
+#include "avail_expr.h"
+#include "dead_code_elimination.h"
+#include "dead_store_elimination.h"
+#include "driver.h"
+#include "global_cse.h"
+#include "lazy_code_motion.h"
+#include "liveness.h"
+#include "memory_liveness.h"
+#include "register_pressure.h"
+#include "sccp.h"
+
+using namespace llvm;
+
+namespace {
+    /// @brief 如果@p name 为"require<@p analysis_name >"或"print<@p analysis_name >", 则把对应的pass加入@p FPM
+    template<class TAnalysisPass>
+    bool ParseAnalysisPipeline(StringRef name, StringRef analysis_name, FunctionPassManager &FPM) {
+        if (name.consume_front("require<") && name.consume_back(">")) {
+            if (name == analysis_name) {
+                FPM.addPass(RequireAnalysisPass<TAnalysisPass, Function>());
+                return true;
+            }
+        } else if (name.consume_front("print<") && name.consume_back(">")) {
+            if (name == analysis_name) {
+                FPM.addPass(dfa::PrinterPass<TAnalysisPass>(outs()));
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /// @brief 如果@p name 为"parallel-print<@p analysis_name >", 则把模块级的并行打印pass加入@p MPM
+    template<class TAnalysis>
+    bool ParseModulePipeline(StringRef name, StringRef analysis_name, ModulePassManager &MPM) {
+        if (name.consume_front("parallel-print<") && name.consume_back(">") && name == analysis_name) {
+            MPM.addPass(dfa::ModulePrinterPass<TAnalysis>(outs()));
+            return true;
+        }
+        return false;
+    }
+
+    PassPluginLibraryInfo GetAssignment2PluginInfo() {
+        return {LLVM_PLUGIN_API_VERSION, "Assignment2", LLVM_VERSION_STRING, [](PassBuilder &PB) {
+            PB.registerAnalysisRegistrationCallback([](FunctionAnalysisManager &FAM) {
+                FAM.registerPass([] { return dfa::LivenessAnalysis(); });
+                FAM.registerPass([] { return dfa::SSALivenessAnalysis(); });
+                FAM.registerPass([] { return dfa::AvailExprAnalysis(); });
+                FAM.registerPass([] { return dfa::ConstantPropagationAnalysis(); });
+                FAM.registerPass([] { return dfa::ValueRangeAnalysis(); });
+                FAM.registerPass([] { return dfa::MemoryLivenessAnalysis(); });
+                FAM.registerPass([] { return dfa::RegisterPressureAnalysis(); });
+            });
+            PB.registerPipelineParsingCallback(
+                    [](StringRef name, FunctionPassManager &FPM, ArrayRef<PassBuilder::PipelineElement>) {
+                        if (name == "dfa-sccp") {
+                            FPM.addPass(dfa::SCCPPass());
+                            return true;
+                        }
+                        if (name == "global-cse") {
+                            FPM.addPass(dfa::GlobalCSEPass());
+                            return true;
+                        }
+                        if (name == "lazy-code-motion") {
+                            FPM.addPass(dfa::LazyCodeMotionPass());
+                            return true;
+                        }
+                        if (name == "dfa-adce") {
+                            FPM.addPass(dfa::AggressiveDCEPass());
+                            return true;
+                        }
+                        if (name == "dfa-dse") {
+                            FPM.addPass(dfa::DeadStoreEliminationPass());
+                            return true;
+                        }
+                        return ParseAnalysisPipeline<dfa::LivenessAnalysis>(name, "liveness", FPM) ||
+                               ParseAnalysisPipeline<dfa::SSALivenessAnalysis>(name, "liveness-ssa", FPM) ||
+                               ParseAnalysisPipeline<dfa::AvailExprAnalysis>(name, "avail-expr", FPM) ||
+                               ParseAnalysisPipeline<dfa::ConstantPropagationAnalysis>(
+                                       name, "constant-propagation", FPM) ||
+                               ParseAnalysisPipeline<dfa::ValueRangeAnalysis>(name, "value-range", FPM) ||
+                               ParseAnalysisPipeline<dfa::MemoryLivenessAnalysis>(name, "memory-liveness", FPM) ||
+                               ParseAnalysisPipeline<dfa::RegisterPressureAnalysis>(name, "register-pressure", FPM);
+                    });
+            PB.registerPipelineParsingCallback(
+                    [](StringRef name, ModulePassManager &MPM, ArrayRef<PassBuilder::PipelineElement>) {
+                        return ParseModulePipeline<dfa::Liveness>(name, "liveness", MPM) ||
+                               ParseModulePipeline<dfa::AvailExpr>(name, "avail-expr", MPM);
+                    });
+        }};
+    }
+} // namespace anonymous
+
+extern "C" LLVM_ATTRIBUTE_WEAK PassPluginLibraryInfo llvmGetPassPluginInfo() {
+    return GetAssignment2PluginInfo();
+}
@@ -0,0 +1,236 @@
+//
+// Created by sakura on 2026/10/17.
+//
+
+#include <algorithm>
+
+#include <llvm/IR/Instructions.h>
+#include "register_pressure.h"
+
+using namespace llvm;
+using dfa::Variable;
+
+namespace dfa {
+    unsigned LiveInterval::size() const {
+        unsigned num = 0;
+        for (const Segment &segment : _segments) {
+            num += segment.end - segment.start + 1;
+        }
+        return num;
+    }
+
+    bool LiveInterval::liveAt(unsigned idx) const {
+        // 第一个end >= idx的段
+        auto segment_iter = std::lower_bound(_segments.begin(), _segments.end(), idx,
+                                             [](const Segment &segment, unsigned idx) {
+                                                 return segment.end < idx;
+                                             });
+        return segment_iter != _segments.end() && segment_iter->start <= idx;
+    }
+
+    unsigned LiveInterval::nextUseAfter(unsigned idx) const {
+        auto use_iter = std::upper_bound(_uses.begin(), _uses.end(), idx);
+        return use_iter != _uses.end() ? *use_iter : -1u;
+    }
+
+    void RegisterPressure::extendInterval(unsigned var_idx, unsigned idx) {
+        SmallVectorImpl<LiveInterval::Segment> &segments = _intervals[var_idx]._segments;
+        if (!segments.empty() && segments.back().end + 1 >= idx) {
+            segments.back().end = idx;
+        } else {
+            segments.push_back({idx, idx});
+        }
+    }
+
+    void RegisterPressure::computeBlock(const BasicBlock &bb) {
+        // 按程序顺序取出所有phi之后的每个程序点的state: 第k个是第k条非phi指令之前的, 最后一个是基本块出口的
+        std::vector<AdaptiveBitSet> points;
+        for (const Instruction *inst = bb.getFirstNonPHI(); inst != nullptr; inst = inst->getNextNode()) {
+            points.push_back(_liveness.InstIn(*inst));
+        }
+        points.push_back(_liveness.BlockOut(bb));
+
+        unsigned first_idx = _insts.size();
+        unsigned point_idx = 0;
+        for (const Instruction &inst : bb) {
+            unsigned idx = _insts.size();
+            _insts.push_back(&inst);
+            _inst_idx[&inst] = idx;
+            if (isa<PHINode>(inst)) {
+                // phi的incoming value只在前驱的出口活跃, 这里只看所有phi之后的程序点
+                _pressure.push_back(points.front().count());
+                for (unsigned var_idx : points.front().set_bits()) {
+                    extendInterval(var_idx, idx);
+                }
+                continue;
+            }
+            const AdaptiveBitSet &before = points[point_idx], &after = points[point_idx + 1];
+            ++point_idx;
+            _pressure.push_back(std::max(before.count(), after.count()));
+            for (unsigned var_idx : before.set_bits()) {
+                extendInterval(var_idx, idx);
+            }
+            for (unsigned var_idx : after.set_bits()) {
+                extendInterval(var_idx, idx);
+            }
+        }
+        // 同一个基本块内压力最大的第一条指令
+        auto max_iter = std::max_element(_pressure.begin() + first_idx, _pressure.end());
+        _block_max[&bb] = max_iter - _pressure.begin();
+    }
+
+    void RegisterPressure::computeUses() {
+        for (LiveInterval &interval : _intervals) {
+            for (const User *user : interval._value->users()) {
+                const auto *user_inst = dyn_cast<Instruction>(user);
+                if (user_inst == nullptr) {
+                    continue;
+                }
+                // phi的use发生在对应前驱的出口
+                if (const auto *phi = dyn_cast<PHINode>(user_inst)) {
+                    for (unsigned in_idx = 0; in_idx < phi->getNumIncomingValues(); ++in_idx) {
+                        if (phi->getIncomingValue(in_idx) == interval._value) {
+                            interval._uses.push_back(getIndex(*phi->getIncomingBlock(in_idx)->getTerminator()));
+                        }
+                    }
+                } else {
+                    interval._uses.push_back(getIndex(*user_inst));
+                }
+            }
+            std::sort(interval._uses.begin(), interval._uses.end());
+            interval._uses.erase(std::unique(interval._uses.begin(), interval._uses.end()), interval._uses.end());
+        }
+    }
+
+    void RegisterPressure::run(const Function &F) {
+        release();
+        _liveness.run(F);
+        const Domain<Variable> &domain = _liveness.domain();
+        for (unsigned var_idx = 0; var_idx < domain.size(); ++var_idx) {
+            _intervals.emplace_back(domain[var_idx].getValue());
+        }
+        for (const BasicBlock &bb : F) {
+            computeBlock(bb);
+        }
+        computeUses();
+        if (!_pressure.empty()) {
+            unsigned max_pressure = *std::max_element(_pressure.begin(), _pressure.end());
+            for (unsigned idx = 0; idx < _pressure.size(); ++idx) {
+                if (_pressure[idx] == max_pressure) {
+                    _max_points.push_back(idx);
+                }
+            }
+        }
+    }
+
+    void RegisterPressure::release() {
+        _liveness.release();
+        _insts.clear();
+        _inst_idx.clear();
+        _pressure.clear();
+        _block_max.clear();
+        _max_points.clear();
+        _intervals.clear();
+    }
+
+    const LiveInterval *RegisterPressure::getInterval(const Value *val) const {
+        int var_idx = _liveness.domain().position(Variable(val));
+        return var_idx != -1 ? &_intervals[var_idx] : nullptr;
+    }
+
+    std::vector<const Value *> RegisterPressure::getSplitCandidates(const Instruction &point) const {
+        unsigned idx = getIndex(point);
+        std::vector<const LiveInterval *> candidates;
+        for (const LiveInterval &interval : _intervals) {
+            // use的编号已经把phi的use算在前驱的terminator上
+            bool used_here = std::binary_search(interval.uses().begin(), interval.uses().end(), idx);
+            if (interval.getValue() != &point && interval.liveAt(idx) && !used_here) {
+                candidates.push_back(&interval);
+            }
+        }
+        // 下一个use越远, 在这里切开之后空出寄存器的时间越长; 没有之后的use时nextUseAfter为-1u, 自然排在最前
+        std::stable_sort(candidates.begin(), candidates.end(),
+                         [idx](const LiveInterval *lhs, const LiveInterval *rhs) {
+                             return lhs->nextUseAfter(idx) > rhs->nextUseAfter(idx);
+                         });
+        std::vector<const Value *> values;
+        for (const LiveInterval *interval : candidates) {
+            values.push_back(interval->getValue());
+        }
+        return values;
+    }
+
+    void RegisterPressure::printInstBVMap(const Function &F, raw_ostream &os) const {
+        os << "********************************************" << "\n";
+        os << "* Register Pressure                         " << "\n";
+        os << "********************************************" << "\n";
+        for (const BasicBlock &bb : F) {
+            os << "Block ";
+            bb.printAsOperand(os, false);
+            os << ": max pressure " << getMaxPressure(bb) << "\n";
+            for (const Instruction &inst : bb) {
+                os << "[" << getIndex(inst) << "]\t" << getPressure(inst) << "\t" << inst << "\n";
+            }
+        }
+        os << "Live Intervals:\n";
+        for (const LiveInterval &interval : _intervals) {
+            os << Variable(interval.getValue()) << ":";
+            for (const LiveInterval::Segment &segment : interval.segments()) {
+                os << " [" << segment.start << "," << segment.end << "]";
+            }
+            os << "\n";
+        }
+        os << "Max pressure " << getMaxPressure() << " at:\n";
+        for (unsigned idx : getMaxPressurePoints()) {
+            os << "[" << idx << "]\t" << *getInstruction(idx) << "\n";
+            os << "\tsplit candidates: {";
+            for (const Value *val : getSplitCandidates(*getInstruction(idx))) {
+                os << Variable(val) << ",";
+            }
+            os << "}\n";
+        }
+    }
+
+    void RegisterPressure::writeResults(const Function &F, OutputFormat format, ResultWriter &writer) const {
+        if (format == OutputFormat::Binary) {
+            writer.write("DFR1");
+            writer.writeBytes(F.getName());
+            writer.writeU32(_pressure.size());
+            for (unsigned pressure : _pressure) {
+                writer.writeU32(pressure);
+            }
+            writer.writeU32(_intervals.size());
+            for (const LiveInterval &interval : _intervals) {
+                writer.writeBytes(ToString(Variable(interval.getValue())));
+                writer.writeU32(interval.segments().size());
+                for (const LiveInterval::Segment &segment : interval.segments()) {
+                    writer.writeU32(segment.start);
+                    writer.writeU32(segment.end);
+                }
+            }
+            return;
+        }
+        assert(format == OutputFormat::JSONL && "Only Binary and JSONL are structured formats.");
+        writer.write("{\"function\":");
+        writer.writeJSONString(F.getName());
+        writer.write(",\"pressure\":");
+        writer.writeJSONArray(_pressure);
+        writer.write(",\"intervals\":[");
+        for (unsigned var_idx = 0; var_idx < _intervals.size(); ++var_idx) {
+            const LiveInterval &interval = _intervals[var_idx];
+            writer.write(var_idx == 0 ? "{\"value\":" : ",{\"value\":");
+            writer.writeJSONString(ToString(Variable(interval.getValue())));
+            writer.write(",\"segments\":[");
+            for (unsigned seg_idx = 0; seg_idx < interval.segments().size(); ++seg_idx) {
+                const LiveInterval::Segment &segment = interval.segments()[seg_idx];
+                writer.write(seg_idx == 0 ? "[" : ",[");
+                writer.writeDecimal(segment.start);
+                writer.write(',');
+                writer.writeDecimal(segment.end);
+                writer.write(']');
+            }
+            writer.write("]}");
+        }
+        writer.write("]}\n");
+    }
+}
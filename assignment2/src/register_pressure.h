@@ -0,0 +1,164 @@
+//
+// Created by sakura on 2026/10/17.
+//
+
+#ifndef ASSIGNMENT2_REGISTER_PRESSURE_H
+#define ASSIGNMENT2_REGISTER_PRESSURE_H
+
+#include <vector>
+
+#include <llvm/ADT/ArrayRef.h>
+#include <llvm/ADT/DenseMap.h>
+#include <llvm/ADT/SmallVector.h>
+#include <llvm/IR/Function.h>
+#include <llvm/Support/raw_ostream.h>
+#include "analysis.h"
+#include "liveness.h"
+#include "output.h"
+
+namespace dfa {
+    /// Live Interval
+    ///
+    /// 一个SSA值在线性编号(函数中所有指令按布局顺序编号, 从0开始)下的活跃区间, 由若干个不相交的闭区间组成.
+    /// 值在指令p之前或之后活跃时, p属于它的区间. 作为phi的incoming value的use记在对应前驱的terminator上.
+    class LiveInterval {
+    public:
+        struct Segment {
+            unsigned start, end;
+        };
+    private:
+        const Value *_value;
+        // 按start递增, 相邻的段之间至少隔着一条指令
+        SmallVector<Segment, 2> _segments;
+        // 所有use的编号, 递增
+        SmallVector<unsigned, 4> _uses;
+
+        friend class RegisterPressure;
+    public:
+        explicit LiveInterval(const Value *value) : _value(value) {}
+
+        const Value *getValue() const { return _value; }
+
+        ArrayRef<Segment> segments() const { return _segments; }
+
+        ArrayRef<unsigned> uses() const { return _uses; }
+
+        /// @brief 区间覆盖的指令数
+        unsigned size() const;
+
+        /// @brief 编号为@p idx 的指令是否在区间内
+        bool liveAt(unsigned idx) const;
+
+        /// @brief 编号大于@p idx 的第一个use, 不存在时返回-1u
+        unsigned nextUseAfter(unsigned idx) const;
+    };
+
+    /// Register Pressure
+    ///
+    /// 在Liveness的结果上计算每个程序点的寄存器压力以及每个值的活跃区间. 每个活跃的SSA值(指令和函数参数)
+    /// 占一个寄存器, 一条指令处的压力是它之前和之后两个程序点活跃的值的个数中较大的一个;
+    /// phi在基本块入口并行地定义, 它们处的压力都是所有phi之后的那个程序点的压力.
+    ///
+    /// 提供与数据流求解器相同的接口(setOptions/run/release/printInstBVMap/writeResults), 所以可以直接用
+    /// LegacyPrinterPass和AnalysisPass包装成pass.
+    class RegisterPressure {
+    private:
+        Liveness _liveness;
+        // 按线性编号排列的指令, 以及指令 -> 编号
+        std::vector<const Instruction *> _insts;
+        DenseMap<const Instruction *, unsigned> _inst_idx;
+        // 每条指令处的压力
+        std::vector<unsigned> _pressure;
+        // 每个基本块内压力最大的第一条指令
+        DenseMap<const BasicBlock *, unsigned> _block_max;
+        // 整个函数中压力等于最大值的指令, 按编号递增
+        std::vector<unsigned> _max_points;
+        // 以liveness的domain编号为下标
+        std::vector<LiveInterval> _intervals;
+
+        /// @brief 给基本块@p bb 的指令编号, 计算其中每条指令处的压力, 并把它们加入活跃区间
+        void computeBlock(const BasicBlock &bb);
+
+        /// @brief 记录每个值的所有use的编号
+        void computeUses();
+
+        /// @brief 把编号为@p idx 的指令加入编号为@p var_idx 的值的活跃区间, 要求编号递增地加入
+        void extendInterval(unsigned var_idx, unsigned idx);
+
+    public:
+        void setOptions(const SolverOptions &options) {
+            _liveness.setOptions(options);
+        }
+
+        uint64_t numTransferEvaluations() const {
+            return _liveness.numTransferEvaluations();
+        }
+
+        /// @brief 求解@p F 的liveness并计算压力和活跃区间, 结果一直保留到下一次run()或release()
+        void run(const Function &F);
+
+        void release();
+
+        /// @brief 底层的liveness结果
+        const Liveness &getLiveness() const { return _liveness; }
+
+        /// @brief 指令@p inst 的线性编号
+        unsigned getIndex(const Instruction &inst) const {
+            return _inst_idx.lookup(&inst);
+        }
+
+        /// @brief 线性编号为@p idx 的指令
+        const Instruction *getInstruction(unsigned idx) const {
+            return _insts[idx];
+        }
+
+        /// @brief 指令@p inst 处的压力
+        unsigned getPressure(const Instruction &inst) const {
+            return _pressure[getIndex(inst)];
+        }
+
+        /// @brief 基本块@p bb 内的最大压力
+        unsigned getMaxPressure(const BasicBlock &bb) const {
+            return _pressure[_block_max.lookup(&bb)];
+        }
+
+        /// @brief 基本块@p bb 内压力最大的第一条指令
+        const Instruction *getMaxPressurePoint(const BasicBlock &bb) const {
+            return _insts[_block_max.lookup(&bb)];
+        }
+
+        /// @brief 整个函数的最大压力, 空函数为0
+        unsigned getMaxPressure() const {
+            return _max_points.empty() ? 0 : _pressure[_max_points.front()];
+        }
+
+        /// @brief 压力等于整个函数最大压力的所有指令的编号
+        ArrayRef<unsigned> getMaxPressurePoints() const { return _max_points; }
+
+        /// @brief 值@p val 的活跃区间, 不在liveness domain中的值(常量, 从未被使用的值)返回nullptr
+        const LiveInterval *getInterval(const Value *val) const;
+
+        /// @brief 值@p val 在指令@p inst 处是否活跃
+        bool isLiveAt(const Value *val, const Instruction &inst) const {
+            const LiveInterval *interval = getInterval(val);
+            return interval != nullptr && interval->liveAt(getIndex(inst));
+        }
+
+        /// @brief  指令@p point 处的split候选: 跨越该点活跃, 但既不在该点定义也不在该点被使用的值,
+        ///         按下一个use的距离从远到近排列(之后没有use的, 例如只在回边上被使用的, 排在最前).
+        ///         在它们的区间上@p point 附近切开(spill/reload)最能降低该点的压力
+        std::vector<const Value *> getSplitCandidates(const Instruction &point) const;
+
+        void printInstBVMap(const Function &F, raw_ostream &os) const;
+
+        /// @brief  以结构化的@p format (Binary或JSONL)写出每条指令处的压力和每个值的活跃区间.
+        ///         Binary: "DFR1", 函数名, u32 指令数, 每条指令的u32压力, u32 区间数,
+        ///                 每个区间: 值的字符串, u32 段数, 每段的u32 start和end
+        ///         JSONL:  {"function":..., "pressure":[...], "intervals":[{"value":..., "segments":[[s,e], ...]}, ...]}
+        void writeResults(const Function &F, OutputFormat format, ResultWriter &writer) const;
+    };
+
+    /// @brief 新pass manager下的register pressure analysis, 结果为缓存的dfa::RegisterPressure
+    typedef AnalysisPass<RegisterPressure> RegisterPressureAnalysis;
+}
+#endif //ASSIGNMENT2_REGISTER_PRESSURE_H
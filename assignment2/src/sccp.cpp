@@ -0,0 +1,105 @@
+//
+// Created by sakura on 2026/10/17.
+//
+
+// 基于LatticeFramework的分析(条件常量传播, 整数区间)的打印pass, 以及根据条件常量传播改写IR的transform:
+//   opt -load libAssignment2.so -constant-propagation input.ll -o /dev/null
+//   opt -load libAssignment2.so -value-range input.ll -o /dev/null
+//   opt -load libAssignment2.so -dfa-sccp -stats input.ll -S -o output.ll
+//   opt -load-pass-plugin=libAssignment2.so -passes='dfa-sccp' input.ll -S -o output.ll
+
+#include <utility>
+#include <vector>
+
+#include <llvm/ADT/Statistic.h>
+#include <llvm/IR/Constants.h>
+#include <llvm/IR/Instructions.h>
+#include <llvm/Pass.h>
+#include <llvm/Transforms/Utils/Local.h>
+#include "sccp.h"
+
+#define DEBUG_TYPE "dfa-sccp"
+
+using namespace llvm;
+
+STATISTIC(NumInstsReplaced, "Number of instructions replaced with constants");
+STATISTIC(NumTerminatorsFolded, "Number of terminators with constant conditions folded");
+STATISTIC(NumBlocksRemoved, "Number of unreachable basic blocks removed");
+
+namespace {
+    class LegacySCCPPass final : public FunctionPass {
+    public:
+        static char ID;
+
+        LegacySCCPPass() : FunctionPass(ID) {}
+
+        virtual ~LegacySCCPPass() override {}
+
+        virtual bool runOnFunction(Function &F) override {
+            return dfa::RunSparseConditionalConstantPropagation(F);
+        }
+    };
+
+    char LegacySCCPPass::ID = 0;
+
+    RegisterPass<dfa::LegacyPrinterPass<dfa::ConstantPropagation>> X(
+            "constant-propagation", "Sparse Conditional Constant Propagation (print lattice values)");
+    RegisterPass<dfa::LegacyPrinterPass<dfa::ValueRange>> Z(
+            "value-range", "Integer Value Range (print lattice values)");
+    RegisterPass<LegacySCCPPass> Y(
+            "dfa-sccp", "Sparse Conditional Constant Propagation");
+} // namespace anonymous
+
+namespace dfa {
+    bool RunSparseConditionalConstantPropagation(Function &F) {
+        ConstantPropagation analysis;
+        analysis.run(F);
+        // 先收集所有常量再改写IR, 改写开始之后不再查询分析结果
+        std::vector<std::pair<Instruction *, Constant *>> replacements;
+        std::vector<BasicBlock *> executable_blocks;
+        for (BasicBlock &bb : F) {
+            if (!analysis.isExecutable(bb)) {
+                continue;
+            }
+            executable_blocks.push_back(&bb);
+            for (Instruction &inst : bb) {
+                if (inst.getType()->isVoidTy()) {
+                    continue;
+                }
+                if (Constant *constant = analysis.getConstant(inst)) {
+                    replacements.emplace_back(&inst, constant);
+                }
+            }
+        }
+        analysis.release();
+
+        bool changed = false;
+        for (const auto &replacement : replacements) {
+            replacement.first->replaceAllUsesWith(replacement.second);
+            ++NumInstsReplaced;
+            changed = true;
+        }
+        for (const auto &replacement : replacements) {
+            if (isInstructionTriviallyDead(replacement.first)) {
+                replacement.first->eraseFromParent();
+            }
+        }
+        // 条件已经被替换为常量的分支只保留可执行的一侧, 另一侧的phi随之更新
+        for (BasicBlock *bb : executable_blocks) {
+            if (ConstantFoldTerminator(bb, true)) {
+                ++NumTerminatorsFolded;
+                changed = true;
+            }
+        }
+        unsigned num_blocks = F.size();
+        if (removeUnreachableBlocks(F)) {
+            NumBlocksRemoved += num_blocks - F.size();
+            changed = true;
+        }
+        return changed;
+    }
+
+    PreservedAnalyses SCCPPass::run(Function &F, FunctionAnalysisManager &) {
+        return RunSparseConditionalConstantPropagation(F) ? PreservedAnalyses::none() : PreservedAnalyses::all();
+    }
+}
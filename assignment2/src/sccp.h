@@ -0,0 +1,31 @@
+//
+// Created by sakura on 2026/10/17.
+//
+
+#ifndef ASSIGNMENT2_SCCP_H
+#define ASSIGNMENT2_SCCP_H
+
+#include <llvm/IR/Function.h>
+#include <llvm/IR/PassManager.h>
+#include "analysis.h"
+#include "constant_propagation.h"
+#include "value_range.h"
+
+namespace dfa {
+    /// @brief 新pass manager下的条件常量传播analysis, 结果为缓存的dfa::ConstantPropagation
+    typedef AnalysisPass<ConstantPropagation> ConstantPropagationAnalysis;
+
+    /// @brief 新pass manager下的整数区间analysis, 结果为缓存的dfa::ValueRange
+    typedef AnalysisPass<ValueRange> ValueRangeAnalysis;
+
+    /// @brief  对@p F 运行条件常量传播并改写IR: 可执行基本块中值为常量的指令被替换为该常量,
+    ///         条件为常量的分支被改为无条件跳转, 之后不再可达的基本块被删除. 返回IR是否改变
+    bool RunSparseConditionalConstantPropagation(llvm::Function &F);
+
+    /// New-PM SCCP Pass
+    class SCCPPass : public llvm::PassInfoMixin<SCCPPass> {
+    public:
+        llvm::PreservedAnalyses run(llvm::Function &F, llvm::FunctionAnalysisManager &);
+    };
+}
+#endif //ASSIGNMENT2_SCCP_H
@@ -0,0 +1,834 @@
+//
+// Created by sakura on 2026/10/17.
+//
+
+#ifndef ASSIGNMENT2_SPARSE_BITSET_H
+#define ASSIGNMENT2_SPARSE_BITSET_H
+
+#include <algorithm>
+#include <cassert>
+#include <climits>
+#include <vector>
+
+#include <llvm/ADT/ArrayRef.h>
+#include <llvm/ADT/SmallVector.h>
+#include <llvm/ADT/iterator_range.h>
+#include <llvm/Support/Allocator.h>
+#include <llvm/Support/MathExtras.h>
+#include "bitset.h"
+
+namespace dfa {
+    /***********************************************************************
+     * Sparse Word Algorithms
+     ***********************************************************************/
+    // 稀疏表示只保存非零的word, 所有集合运算都是按word下标递增的归并.
+    // WordCursor把稠密的word数组和稀疏的(下标, word)数组统一成同一种"非零word序列",
+    // 因此同一套归并算法可以同时处理两种表示的operand.
+    namespace sparse {
+        typedef kernel::word_t word_t;
+
+        /// @brief 一个非零word及其下标
+        struct Element {
+            unsigned idx;
+            word_t bits;
+
+            bool operator==(const Element &other) const { return idx == other.idx && bits == other.bits; }
+
+            bool operator!=(const Element &other) const { return !(*this == other); }
+        };
+
+        /// @brief 按下标递增的顺序遍历一个集合的所有非零word
+        class WordCursor {
+        private:
+            const Element *_elem = nullptr, *_elem_end = nullptr;
+            const word_t *_words = nullptr;
+            unsigned _num_words = 0, _pos = 0;
+            bool _dense = false;
+
+            void skipZeros() {
+                while (_pos < _num_words && _words[_pos] == 0) {
+                    ++_pos;
+                }
+            }
+
+        public:
+            /// @brief 遍历结束之后idx()的返回值, 大于任何合法的下标
+            static constexpr unsigned End = UINT_MAX;
+
+            WordCursor(const Element *begin, const Element *end) : _elem(begin), _elem_end(end) {}
+
+            explicit WordCursor(llvm::ArrayRef<Element> elems) : WordCursor(elems.begin(), elems.end()) {}
+
+            WordCursor(const word_t *words, unsigned num_words) : _words(words), _num_words(num_words), _dense(true) {
+                skipZeros();
+            }
+
+            bool done() const { return idx() == End; }
+
+            /// @brief 当前word的下标, 遍历结束时为End
+            unsigned idx() const {
+                if (_dense) {
+                    return _pos < _num_words ? _pos : End;
+                }
+                return _elem != _elem_end ? _elem->idx : End;
+            }
+
+            word_t bits() const { return _dense ? _words[_pos] : _elem->bits; }
+
+            void next() {
+                if (_dense) {
+                    ++_pos;
+                    skipZeros();
+                } else {
+                    ++_elem;
+                }
+            }
+
+            /// @brief 返回下标为@p idx 的word, 不存在则返回0.
+            ///        对同一个cursor的多次调用中@p idx 必须单调不减, 且不能与next()混用.
+            word_t at(unsigned idx) {
+                if (_dense) {
+                    return idx < _num_words ? _words[idx] : 0;
+                }
+                while (_elem != _elem_end && _elem->idx < idx) {
+                    ++_elem;
+                }
+                return _elem != _elem_end && _elem->idx == idx ? _elem->bits : 0;
+            }
+        };
+
+        /// @brief out = ops[0] ∪ ops[1] ∪ ..., 若@p kills 非空, 则每个operand先减去对应的kill
+        inline void Meet(kernel::OrOp, std::vector<Element> &out, llvm::MutableArrayRef<WordCursor> ops,
+                         llvm::MutableArrayRef<WordCursor> kills) {
+            out.clear();
+            while (true) {
+                unsigned idx = WordCursor::End;
+                for (const WordCursor &op : ops) {
+                    idx = std::min(idx, op.idx());
+                }
+                if (idx == WordCursor::End) {
+                    return;
+                }
+                word_t acc = 0;
+                for (unsigned s = 0; s < ops.size(); ++s) {
+                    if (ops[s].idx() != idx) {
+                        continue;
+                    }
+                    word_t bits = ops[s].bits();
+                    if (!kills.empty()) {
+                        bits &= ~kills[s].at(idx);
+                    }
+                    acc |= bits;
+                    ops[s].next();
+                }
+                if (acc != 0) {
+                    out.push_back({idx, acc});
+                }
+            }
+        }
+
+        /// @brief out = ops[0] ∩ ops[1] ∩ ..., 若@p kills 非空, 则每个operand先减去对应的kill.
+        ///        只遍历ops[0]的非零word, 其余operand按下标查找.
+        inline void Meet(kernel::AndOp, std::vector<Element> &out, llvm::MutableArrayRef<WordCursor> ops,
+                         llvm::MutableArrayRef<WordCursor> kills) {
+            out.clear();
+            for (; !ops[0].done(); ops[0].next()) {
+                unsigned idx = ops[0].idx();
+                word_t acc = ops[0].bits();
+                if (!kills.empty()) {
+                    acc &= ~kills[0].at(idx);
+                }
+                for (unsigned s = 1; acc != 0 && s < ops.size(); ++s) {
+                    word_t bits = ops[s].at(idx);
+                    if (!kills.empty()) {
+                        bits &= ~kills[s].at(idx);
+                    }
+                    acc &= bits;
+                }
+                if (acc != 0) {
+                    out.push_back({idx, acc});
+                }
+            }
+        }
+
+        /// @brief out = (in - kill) ∪ gen
+        inline void Transfer(std::vector<Element> &out, WordCursor in, WordCursor gen, WordCursor kill) {
+            out.clear();
+            while (true) {
+                unsigned idx = std::min(in.idx(), gen.idx());
+                if (idx == WordCursor::End) {
+                    return;
+                }
+                word_t bits = 0;
+                if (in.idx() == idx) {
+                    bits = in.bits() & ~kill.at(idx);
+                    in.next();
+                }
+                if (gen.idx() == idx) {
+                    bits |= gen.bits();
+                    gen.next();
+                }
+                if (bits != 0) {
+                    out.push_back({idx, bits});
+                }
+            }
+        }
+
+        /// @brief out = in - mask
+        inline void Subtract(std::vector<Element> &out, WordCursor in, WordCursor mask) {
+            out.clear();
+            for (; !in.done(); in.next()) {
+                word_t bits = in.bits() & ~mask.at(in.idx());
+                if (bits != 0) {
+                    out.push_back({in.idx(), bits});
+                }
+            }
+        }
+
+        /// @brief 两个集合是否相等(只比较非零word)
+        inline bool Equal(WordCursor lhs, WordCursor rhs) {
+            for (; !lhs.done() || !rhs.done(); lhs.next(), rhs.next()) {
+                if (lhs.idx() != rhs.idx() || lhs.bits() != rhs.bits()) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        /// @brief 每个线程一个的临时数组, 运算结果先写到这里, 再与目标集合交换存储, 从而复用两边的内存
+        inline std::vector<Element> &Scratch() {
+            static thread_local std::vector<Element> scratch;
+            return scratch;
+        }
+
+        /// @brief 去掉@p elems 中超出@p size 个bit的部分
+        inline void Truncate(std::vector<Element> &elems, unsigned size) {
+            unsigned num_words = BitSet::NumWords(size);
+            while (!elems.empty() && elems.back().idx >= num_words) {
+                elems.pop_back();
+            }
+            unsigned used = size % BitSet::WordBits;
+            if (!elems.empty() && used != 0 && elems.back().idx == num_words - 1) {
+                elems.back().bits &= ~word_t(0) >> (BitSet::WordBits - used);
+                if (elems.back().bits == 0) {
+                    elems.pop_back();
+                }
+            }
+        }
+
+        /// @brief 遍历所有为1的bit的下标
+        class SetBitsIterator {
+        private:
+            WordCursor _cursor;
+            // 当前word中还没有访问过的bit, 以及当前word的下标
+            word_t _remaining = 0;
+            unsigned _word_idx = 0;
+            int _current = -1;
+
+        public:
+            /// @brief 构造指向@p cursor 中第一个bit的iterator
+            explicit SetBitsIterator(WordCursor cursor) : _cursor(cursor) {
+                ++*this;
+            }
+
+            /// @brief 构造end iterator
+            SetBitsIterator() : _cursor(nullptr, nullptr) {}
+
+            unsigned operator*() const { return _current; }
+
+            SetBitsIterator &operator++() {
+                if (_remaining == 0) {
+                    if (_cursor.done()) {
+                        _current = -1;
+                        return *this;
+                    }
+                    _word_idx = _cursor.idx();
+                    _remaining = _cursor.bits();
+                    _cursor.next();
+                }
+                _current = _word_idx * BitSet::WordBits + llvm::countTrailingZeros(_remaining);
+                _remaining &= _remaining - 1;
+                return *this;
+            }
+
+            bool operator==(const SetBitsIterator &other) const { return _current == other._current; }
+
+            bool operator!=(const SetBitsIterator &other) const { return _current != other._current; }
+        };
+    }
+
+    /***********************************************************************
+     * SparseBitSet
+     ***********************************************************************/
+    /// Sparse Bit Set
+    ///
+    /// 只保存非零的word, 以(下标, word)的形式按下标递增排列, 内存与集合中的元素个数成正比,
+    /// 与domain的大小无关. 接口与BitSet相同, 可以作为Framework的TSet模板参数.
+    /// 不变式: 不含值为0的word, 不含超出size()的bit.
+    class SparseBitSet {
+    public:
+        typedef kernel::word_t word_t;
+        typedef sparse::Element Element;
+        typedef sparse::SetBitsIterator const_set_bits_iterator;
+
+    private:
+        std::vector<Element> _elems;
+        unsigned _size = 0;
+
+        /// @brief 返回第一个下标不小于@p word_idx 的元素
+        std::vector<Element>::iterator lowerBound(unsigned word_idx) {
+            return std::lower_bound(_elems.begin(), _elems.end(), word_idx,
+                                    [](const Element &elem, unsigned target) { return elem.idx < target; });
+        }
+
+        std::vector<Element>::const_iterator lowerBound(unsigned word_idx) const {
+            return std::lower_bound(_elems.begin(), _elems.end(), word_idx,
+                                    [](const Element &elem, unsigned target) { return elem.idx < target; });
+        }
+
+        /// @brief 用@p result 替换当前的元素, @p result 换回上一次的存储以便复用
+        void adopt(std::vector<Element> &result) {
+            _elems.swap(result);
+        }
+
+    public:
+        SparseBitSet() = default;
+
+        explicit SparseBitSet(unsigned size, bool value = false) : _size(size) {
+            if (value) {
+                set();
+            }
+        }
+
+        unsigned size() const { return _size; }
+
+        /// @brief 非零word的个数
+        unsigned numElements() const { return _elems.size(); }
+
+        /// @brief 元素数组占用的字节数
+        size_t bytes() const { return _elems.capacity() * sizeof(Element); }
+
+        sparse::WordCursor cursor() const { return sparse::WordCursor(_elems); }
+
+        /// @brief 改变大小, 新增的bit为0
+        void resize(unsigned size) {
+            if (size < _size) {
+                sparse::Truncate(_elems, size);
+            }
+            _size = size;
+        }
+
+        bool test(unsigned idx) const {
+            assert(idx < _size && "SparseBitSet index out of range.");
+            auto iter = lowerBound(idx / BitSet::WordBits);
+            return iter != _elems.end() && iter->idx == idx / BitSet::WordBits &&
+                   ((iter->bits >> (idx % BitSet::WordBits)) & 1);
+        }
+
+        bool operator[](unsigned idx) const { return test(idx); }
+
+        SparseBitSet &set(unsigned idx) {
+            assert(idx < _size && "SparseBitSet index out of range.");
+            unsigned word_idx = idx / BitSet::WordBits;
+            word_t bit = word_t(1) << (idx % BitSet::WordBits);
+            auto iter = lowerBound(word_idx);
+            if (iter != _elems.end() && iter->idx == word_idx) {
+                iter->bits |= bit;
+            } else {
+                _elems.insert(iter, {word_idx, bit});
+            }
+            return *this;
+        }
+
+        SparseBitSet &reset(unsigned idx) {
+            assert(idx < _size && "SparseBitSet index out of range.");
+            unsigned word_idx = idx / BitSet::WordBits;
+            auto iter = lowerBound(word_idx);
+            if (iter != _elems.end() && iter->idx == word_idx) {
+                iter->bits &= ~(word_t(1) << (idx % BitSet::WordBits));
+                if (iter->bits == 0) {
+                    _elems.erase(iter);
+                }
+            }
+            return *this;
+        }
+
+        /// @brief 将所有bit置1, 此时稀疏表示并不省内存, 全集应尽量避免使用SparseBitSet
+        SparseBitSet &set() {
+            _elems.clear();
+            for (unsigned word_idx = 0; word_idx < BitSet::NumWords(_size); ++word_idx) {
+                _elems.push_back({word_idx, ~word_t(0)});
+            }
+            sparse::Truncate(_elems, _size);
+            return *this;
+        }
+
+        /// @brief 将所有bit置0
+        SparseBitSet &reset() {
+            _elems.clear();
+            return *this;
+        }
+
+        /// @brief *this = *this - @p mask
+        SparseBitSet &reset(const SparseBitSet &mask) {
+            std::vector<Element> &result = sparse::Scratch();
+            sparse::Subtract(result, cursor(), mask.cursor());
+            adopt(result);
+            return *this;
+        }
+
+        /// @brief *this = *this ∪ @p other, @p other 可以比*this短
+        SparseBitSet &operator|=(const SparseBitSet &other) {
+            assert(other._size <= _size);
+            sparse::WordCursor ops[] = {cursor(), other.cursor()};
+            std::vector<Element> &result = sparse::Scratch();
+            sparse::Meet(kernel::OrOp(), result, ops, {});
+            adopt(result);
+            return *this;
+        }
+
+        SparseBitSet &operator&=(const SparseBitSet &other) {
+            assert(other._size == _size);
+            sparse::WordCursor ops[] = {cursor(), other.cursor()};
+            std::vector<Element> &result = sparse::Scratch();
+            sparse::Meet(kernel::AndOp(), result, ops, {});
+            adopt(result);
+            return *this;
+        }
+
+        bool operator==(const SparseBitSet &other) const {
+            return _size == other._size && _elems == other._elems;
+        }
+
+        bool operator!=(const SparseBitSet &other) const { return !(*this == other); }
+
+        bool any() const { return !_elems.empty(); }
+
+        unsigned count() const {
+            unsigned num = 0;
+            for (const Element &elem : _elems) {
+                num += llvm::countPopulation(elem.bits);
+            }
+            return num;
+        }
+
+        llvm::iterator_range<const_set_bits_iterator> set_bits() const {
+            return llvm::make_range(const_set_bits_iterator(cursor()), const_set_bits_iterator());
+        }
+
+        /// @brief *this = (@p in - @p kill) ∪ @p gen
+        /// @return *this是否被改变
+        bool assignTransfer(const SparseBitSet &in, const SparseBitSet &gen, const SparseBitSet &kill) {
+            assert(in._size == _size && gen._size == _size && kill._size == _size);
+            std::vector<Element> &result = sparse::Scratch();
+            sparse::Transfer(result, in.cursor(), gen.cursor(), kill.cursor());
+            bool changed = result != _elems;
+            adopt(result);
+            return changed;
+        }
+
+        /// @brief *this = @p operands[0] op @p operands[1] op ..., 要求@p operands 非空
+        template<class TOp>
+        void assignMeet(llvm::ArrayRef<const SparseBitSet *> operands) {
+            assert(!operands.empty());
+            llvm::SmallVector<sparse::WordCursor, 4> ops;
+            for (const SparseBitSet *operand : operands) {
+                assert(operand->_size == _size);
+                ops.push_back(operand->cursor());
+            }
+            std::vector<Element> &result = sparse::Scratch();
+            sparse::Meet(TOp(), result, ops, {});
+            adopt(result);
+        }
+
+        /// @brief *this = (@p operands[0] - @p kills[0]) op (@p operands[1] - @p kills[1]) op ...
+        template<class TOp>
+        void assignMeetMasked(llvm::ArrayRef<const SparseBitSet *> operands, llvm::ArrayRef<const SparseBitSet *> kills) {
+            assert(!operands.empty() && operands.size() == kills.size());
+            llvm::SmallVector<sparse::WordCursor, 4> ops, kill_ops;
+            for (unsigned i = 0; i < operands.size(); ++i) {
+                assert(operands[i]->_size == _size && kills[i]->_size == _size);
+                ops.push_back(operands[i]->cursor());
+                kill_ops.push_back(kills[i]->cursor());
+            }
+            std::vector<Element> &result = sparse::Scratch();
+            sparse::Meet(TOp(), result, ops, kill_ops);
+            adopt(result);
+        }
+    };
+
+    /***********************************************************************
+     * AdaptiveBitSet
+     ***********************************************************************/
+    /// Adaptive Bit Set
+    ///
+    /// 根据密度在稠密表示(BitSet)与稀疏表示之间切换: 非零word超过总word数的1/DenseRatio时转为稠密,
+    /// 稠密时非零word不超过1/SparseRatio时转回稀疏, 两个阈值之间保持原来的表示以避免反复切换.
+    /// 所有operand都是稠密表示时直接使用BitSet的SIMD kernel, 否则按非零word归并.
+    class AdaptiveBitSet {
+    public:
+        typedef kernel::word_t word_t;
+        typedef sparse::Element Element;
+        typedef sparse::SetBitsIterator const_set_bits_iterator;
+
+        static constexpr unsigned DenseRatio = 2;
+        static constexpr unsigned SparseRatio = 8;
+
+    private:
+        unsigned _size = 0;
+        bool _dense = false;
+        BitSet _bits;                   // 稠密表示, 只在_dense时有效
+        std::vector<Element> _elems;    // 稀疏表示, 只在!_dense时有效
+
+        void toDense() {
+            _bits = BitSet(_size);
+            for (const Element &elem : _elems) {
+                _bits.words()[elem.idx] = elem.bits;
+            }
+            _elems.clear();
+            _dense = true;
+        }
+
+        void toSparse() {
+            _elems.clear();
+            for (sparse::WordCursor cur = cursor(); !cur.done(); cur.next()) {
+                _elems.push_back({cur.idx(), cur.bits()});
+            }
+            _bits = BitSet();
+            _dense = false;
+        }
+
+        /// @brief 稀疏表示的元素变多之后, 检查是否应当转为稠密
+        void adaptSparse() {
+            if (!_dense && _elems.size() * DenseRatio > BitSet::NumWords(_size)) {
+                toDense();
+            }
+        }
+
+        /// @brief 稠密表示经过一次整体运算之后, 检查是否应当转回稀疏
+        void adaptDense() {
+            if (!_dense) {
+                return;
+            }
+            unsigned num_nonzero = 0;
+            for (unsigned i = 0; i < _bits.numWords(); ++i) {
+                num_nonzero += _bits.words()[i] != 0;
+            }
+            if (num_nonzero * SparseRatio <= _bits.numWords()) {
+                toSparse();
+            }
+        }
+
+        /// @brief 用归并得到的@p result 替换当前的内容, 然后根据密度选择表示
+        void adopt(std::vector<Element> &result) {
+            _elems.swap(result);
+            if (_dense) {
+                _bits = BitSet();
+                _dense = false;
+            }
+            adaptSparse();
+        }
+
+    public:
+        AdaptiveBitSet() = default;
+
+        explicit AdaptiveBitSet(unsigned size, bool value = false) : _size(size) {
+            if (value) {
+                set();
+            }
+        }
+
+        unsigned size() const { return _size; }
+
+        bool isDense() const { return _dense; }
+
+        /// @brief 当前表示占用的字节数
+        size_t bytes() const { return _dense ? _bits.bytes() : _elems.capacity() * sizeof(Element); }
+
+        sparse::WordCursor cursor() const {
+            return _dense ? sparse::WordCursor(_bits.words(), _bits.numWords()) : sparse::WordCursor(_elems);
+        }
+
+        /// @brief 改变大小, 新增的bit为0
+        void resize(unsigned size) {
+            if (_dense) {
+                _bits.resize(size);
+            } else if (size < _size) {
+                sparse::Truncate(_elems, size);
+            }
+            _size = size;
+        }
+
+        bool test(unsigned idx) const {
+            assert(idx < _size && "AdaptiveBitSet index out of range.");
+            if (_dense) {
+                return _bits.test(idx);
+            }
+            unsigned word_idx = idx / BitSet::WordBits;
+            auto iter = std::lower_bound(_elems.begin(), _elems.end(), word_idx,
+                                         [](const Element &elem, unsigned target) { return elem.idx < target; });
+            return iter != _elems.end() && iter->idx == word_idx && ((iter->bits >> (idx % BitSet::WordBits)) & 1);
+        }
+
+        bool operator[](unsigned idx) const { return test(idx); }
+
+        AdaptiveBitSet &set(unsigned idx) {
+            assert(idx < _size && "AdaptiveBitSet index out of range.");
+            if (_dense) {
+                _bits.set(idx);
+                return *this;
+            }
+            unsigned word_idx = idx / BitSet::WordBits;
+            word_t bit = word_t(1) << (idx % BitSet::WordBits);
+            auto iter = std::lower_bound(_elems.begin(), _elems.end(), word_idx,
+                                         [](const Element &elem, unsigned target) { return elem.idx < target; });
+            if (iter != _elems.end() && iter->idx == word_idx) {
+                iter->bits |= bit;
+            } else {
+                _elems.insert(iter, {word_idx, bit});
+                adaptSparse();
+            }
+            return *this;
+        }
+
+        AdaptiveBitSet &reset(unsigned idx) {
+            assert(idx < _size && "AdaptiveBitSet index out of range.");
+            if (_dense) {
+                _bits.reset(idx);
+                return *this;
+            }
+            unsigned word_idx = idx / BitSet::WordBits;
+            auto iter = std::lower_bound(_elems.begin(), _elems.end(), word_idx,
+                                         [](const Element &elem, unsigned target) { return elem.idx < target; });
+            if (iter != _elems.end() && iter->idx == word_idx) {
+                iter->bits &= ~(word_t(1) << (idx % BitSet::WordBits));
+                if (iter->bits == 0) {
+                    _elems.erase(iter);
+                }
+            }
+            return *this;
+        }
+
+        /// @brief 将所有bit置1, 全集总是稠密表示
+        AdaptiveBitSet &set() {
+            _elems.clear();
+            _bits = BitSet(_size, true);
+            _dense = true;
+            return *this;
+        }
+
+        /// @brief 将所有bit置0, 空集总是稀疏表示
+        AdaptiveBitSet &reset() {
+            _elems.clear();
+            _bits = BitSet();
+            _dense = false;
+            return *this;
+        }
+
+        /// @brief *this = *this - @p mask
+        AdaptiveBitSet &reset(const AdaptiveBitSet &mask) {
+            assert(mask._size == _size);
+            if (_dense && mask._dense) {
+                _bits.reset(mask._bits);
+            } else if (_dense) {
+                for (sparse::WordCursor cur = mask.cursor(); !cur.done(); cur.next()) {
+                    _bits.words()[cur.idx()] &= ~cur.bits();
+                }
+            } else {
+                std::vector<Element> &result = sparse::Scratch();
+                sparse::Subtract(result, cursor(), mask.cursor());
+                _elems.swap(result);
+            }
+            return *this;
+        }
+
+        /// @brief *this = *this ∪ @p other, @p other 可以比*this短
+        AdaptiveBitSet &operator|=(const AdaptiveBitSet &other) {
+            assert(other._size <= _size);
+            if (_dense && other._dense) {
+                _bits |= other._bits;
+            } else if (_dense) {
+                for (sparse::WordCursor cur = other.cursor(); !cur.done(); cur.next()) {
+                    _bits.words()[cur.idx()] |= cur.bits();
+                }
+            } else {
+                sparse::WordCursor ops[] = {cursor(), other.cursor()};
+                std::vector<Element> &result = sparse::Scratch();
+                sparse::Meet(kernel::OrOp(), result, ops, {});
+                adopt(result);
+            }
+            return *this;
+        }
+
+        bool operator==(const AdaptiveBitSet &other) const {
+            if (_size != other._size) {
+                return false;
+            }
+            if (_dense && other._dense) {
+                return _bits == other._bits;
+            }
+            return sparse::Equal(cursor(), other.cursor());
+        }
+
+        bool operator!=(const AdaptiveBitSet &other) const { return !(*this == other); }
+
+        bool any() const { return _dense ? _bits.any() : !_elems.empty(); }
+
+        unsigned count() const {
+            if (_dense) {
+                return _bits.count();
+            }
+            unsigned num = 0;
+            for (const Element &elem : _elems) {
+                num += llvm::countPopulation(elem.bits);
+            }
+            return num;
+        }
+
+        llvm::iterator_range<const_set_bits_iterator> set_bits() const {
+            return llvm::make_range(const_set_bits_iterator(cursor()), const_set_bits_iterator());
+        }
+
+        /// @brief *this = (@p in - @p kill) ∪ @p gen
+        /// @return *this是否被改变
+        bool assignTransfer(const AdaptiveBitSet &in, const AdaptiveBitSet &gen, const AdaptiveBitSet &kill) {
+            assert(in._size == _size && gen._size == _size && kill._size == _size);
+            if (_dense && in._dense && gen._dense && kill._dense) {
+                bool changed = _bits.assignTransfer(in._bits, gen._bits, kill._bits);
+                if (changed) {
+                    adaptDense();
+                }
+                return changed;
+            }
+            std::vector<Element> &result = sparse::Scratch();
+            sparse::Transfer(result, in.cursor(), gen.cursor(), kill.cursor());
+            bool changed = !sparse::Equal(sparse::WordCursor(result), cursor());
+            adopt(result);
+            return changed;
+        }
+
+        /// @brief *this = @p operands[0] op @p operands[1] op ..., 要求@p operands 非空
+        template<class TOp>
+        void assignMeet(llvm::ArrayRef<const AdaptiveBitSet *> operands) {
+            assert(!operands.empty());
+            bool all_dense = true;
+            for (const AdaptiveBitSet *operand : operands) {
+                assert(operand->_size == _size);
+                all_dense &= operand->_dense;
+            }
+            if (all_dense) {
+                llvm::SmallVector<const BitSet *, 4> dense_operands;
+                for (const AdaptiveBitSet *operand : operands) {
+                    dense_operands.push_back(&operand->_bits);
+                }
+                if (!_dense) {
+                    _elems.clear();
+                    _bits = BitSet(_size);
+                    _dense = true;
+                }
+                _bits.assignMeet<TOp>(dense_operands);
+                adaptDense();
+                return;
+            }
+            llvm::SmallVector<sparse::WordCursor, 4> ops;
+            for (const AdaptiveBitSet *operand : operands) {
+                ops.push_back(operand->cursor());
+            }
+            std::vector<Element> &result = sparse::Scratch();
+            sparse::Meet(TOp(), result, ops, {});
+            adopt(result);
+        }
+
+        /// @brief *this = (@p operands[0] - @p kills[0]) op (@p operands[1] - @p kills[1]) op ...
+        template<class TOp>
+        void assignMeetMasked(llvm::ArrayRef<const AdaptiveBitSet *> operands,
+                              llvm::ArrayRef<const AdaptiveBitSet *> kills) {
+            assert(!operands.empty() && operands.size() == kills.size());
+            bool all_dense = true;
+            for (unsigned i = 0; i < operands.size(); ++i) {
+                assert(operands[i]->_size == _size && kills[i]->_size == _size);
+                all_dense &= operands[i]->_dense && kills[i]->_dense;
+            }
+            if (all_dense) {
+                llvm::SmallVector<const BitSet *, 4> dense_operands, dense_kills;
+                for (unsigned i = 0; i < operands.size(); ++i) {
+                    dense_operands.push_back(&operands[i]->_bits);
+                    dense_kills.push_back(&kills[i]->_bits);
+                }
+                if (!_dense) {
+                    _elems.clear();
+                    _bits = BitSet(_size);
+                    _dense = true;
+                }
+                _bits.assignMeetMasked<TOp>(dense_operands, dense_kills);
+                adaptDense();
+                return;
+            }
+            llvm::SmallVector<sparse::WordCursor, 4> ops, kill_ops;
+            for (unsigned i = 0; i < operands.size(); ++i) {
+                ops.push_back(operands[i]->cursor());
+                kill_ops.push_back(kills[i]->cursor());
+            }
+            std::vector<Element> &result = sparse::Scratch();
+            sparse::Meet(TOp(), result, ops, kill_ops);
+            adopt(result);
+        }
+    };
+
+    /***********************************************************************
+     * State Storage
+     ***********************************************************************/
+    /// @brief 通用的state矩阵, 每一行是一个独立的集合, 内存随各行集合的大小变化, 不使用arena
+    template<class TSet>
+    class SetMatrix {
+    private:
+        std::vector<TSet> _rows;
+    public:
+        void allocate(llvm::BumpPtrAllocator &, unsigned num_rows, unsigned row_bits, bool value = false) {
+            _rows.assign(num_rows, TSet(row_bits, value));
+        }
+
+        void clear() { _rows.clear(); }
+
+        TSet &operator[](unsigned row) {
+            assert(row < _rows.size() && "SetMatrix row out of range.");
+            return _rows[row];
+        }
+
+        const TSet &operator[](unsigned row) const {
+            assert(row < _rows.size() && "SetMatrix row out of range.");
+            return _rows[row];
+        }
+
+        /// @brief 返回从第@p start 行开始的连续@p num 行
+        llvm::MutableArrayRef<TSet> slice(unsigned start, unsigned num) {
+            assert(start + num <= _rows.size() && "SetMatrix row out of range.");
+            return llvm::MutableArrayRef<TSet>(_rows.data() + start, num);
+        }
+
+        unsigned rows() const { return _rows.size(); }
+
+        bool empty() const { return _rows.empty(); }
+
+        /// @brief 所有行以及它们各自的存储占用的字节数
+        size_t bytes() const {
+            size_t num = _rows.capacity() * sizeof(TSet);
+            for (const TSet &row : _rows) {
+                num += row.bytes();
+            }
+            return num;
+        }
+    };
+
+    /// @brief 根据集合的表示选择state的存储方式: 稠密的BitSet放在arena中连续的BitMatrix里, 其他表示逐行存放
+    template<class TSet>
+    struct StateMatrix {
+        typedef SetMatrix<TSet> type;
+    };
+
+    template<>
+    struct StateMatrix<BitSet> {
+        typedef BitMatrix type;
+    };
+}
+#endif //ASSIGNMENT2_SPARSE_BITSET_H
@@ -0,0 +1,35 @@
+//
+// Created by sakura on 2026/10/17.
+//
+
+// 求解器的计数(迭代轮数, 传递函数与meet的次数, domain大小, state字节数)累加到LLVM Statistic中(-stats).
+// 这里不注册任何pass和命令行选项, 所以可以与liveness.cpp等一起编译进其他插件(assignment3).
+
+#include <llvm/ADT/Statistic.h>
+#include "framework.h"
+
+#define DEBUG_TYPE "dfa"
+
+using namespace llvm;
+
+STATISTIC(NumSolves, "Number of dataflow solves (run or update)");
+STATISTIC(NumIterations, "Number of solver iterations over the traversal order");
+STATISTIC(NumTransfers, "Number of block transfer function evaluations");
+STATISTIC(NumMeets, "Number of meet operations");
+STATISTIC(NumDomainElements, "Sum of the domain sizes of all solves");
+STATISTIC(MaxDomainSize, "Largest domain of a single solve");
+STATISTIC(NumStateBytes, "Sum of the block and edge state bytes of all solves");
+STATISTIC(MaxStateBytes, "Largest block and edge state of a single solve in bytes");
+
+namespace dfa {
+    void RecordSolverStatistics(const SolverStatistics &stats) {
+        ++NumSolves;
+        NumIterations += stats.iterations;
+        NumTransfers += stats.transfers;
+        NumMeets += stats.meets;
+        NumDomainElements += stats.domain_size;
+        MaxDomainSize.updateMax(stats.domain_size);
+        NumStateBytes += stats.state_bytes;
+        MaxStateBytes.updateMax(stats.state_bytes);
+    }
+} // namespace dfa
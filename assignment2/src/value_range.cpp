@@ -0,0 +1,197 @@
+//
+// Created by sakura on 2026/10/17.
+//
+
+// 与constant_propagation.cpp一样不注册pass, assignment1中的LocalOpts直接编译这个文件,
+// 打印pass(-value-range)见sccp.cpp.
+
+#include <algorithm>
+
+#include <llvm/IR/Instructions.h>
+#include <llvm/IR/Operator.h>
+#include "value_range.h"
+
+using namespace llvm;
+using dfa::IntegerRange;
+
+namespace {
+    /// @brief 宽度为1的区间, 只包含@p value
+    ConstantRange BoolRange(bool value) {
+        return ConstantRange(APInt(1, value ? 1 : 0));
+    }
+}
+
+namespace dfa {
+    IntegerRange ValueRange::Transfer(const Instruction &inst) const {
+        if (!inst.getType()->isIntegerTy()) {
+            return IntegerRange::overdefined();
+        }
+        unsigned width = inst.getType()->getIntegerBitWidth();
+        // 有副作用或者读内存的指令(call, load等)可以是任何值
+        if (inst.mayHaveSideEffects() || inst.mayReadFromMemory() || inst.isTerminator()) {
+            return IntegerRange::get(ConstantRange::getFull(width));
+        }
+        // 整数操作数的区间, 任何一个还是Undefined时乐观地认为结果也是Undefined
+        SmallVector<ConstantRange, 3> ranges;
+        for (const Use &op : inst.operands()) {
+            if (!op->getType()->isIntegerTy()) {
+                continue;
+            }
+            IntegerRange value = getValue(op.get());
+            if (value.isUndefined()) {
+                return IntegerRange();
+            }
+            ranges.push_back(value.getRange());
+        }
+
+        if (const auto *bin_op = dyn_cast<BinaryOperator>(&inst)) {
+            const auto opcode = bin_op->getOpcode();
+            if (const auto *overflowing = dyn_cast<OverflowingBinaryOperator>(bin_op)) {
+                unsigned no_wrap = 0;
+                if (overflowing->hasNoSignedWrap()) {
+                    no_wrap |= OverflowingBinaryOperator::NoSignedWrap;
+                }
+                if (overflowing->hasNoUnsignedWrap()) {
+                    no_wrap |= OverflowingBinaryOperator::NoUnsignedWrap;
+                }
+                return IntegerRange::get(ranges[0].overflowingBinaryOp(opcode, ranges[1], no_wrap));
+            }
+            return IntegerRange::get(ranges[0].binaryOp(opcode, ranges[1]));
+        }
+        if (const auto *cmp = dyn_cast<ICmpInst>(&inst)) {
+            // 比较指针等非整数时没有区间
+            if (ranges.size() != 2) {
+                return IntegerRange::get(ConstantRange::getFull(1));
+            }
+            if (ranges[0].icmp(cmp->getPredicate(), ranges[1])) {
+                return IntegerRange::get(BoolRange(true));
+            }
+            if (ranges[0].icmp(cmp->getInversePredicate(), ranges[1])) {
+                return IntegerRange::get(BoolRange(false));
+            }
+            return IntegerRange::get(ConstantRange::getFull(1));
+        }
+        if (const auto *cast = dyn_cast<CastInst>(&inst)) {
+            if (ranges.empty()) {
+                return IntegerRange::get(ConstantRange::getFull(width));
+            }
+            return IntegerRange::get(ranges[0].castOp(cast->getOpcode(), width));
+        }
+        if (const auto *select = dyn_cast<SelectInst>(&inst)) {
+            // 条件(i1)以及两个整数操作数
+            const ConstantRange &cond = ranges[0];
+            IntegerRange true_value = getValue(select->getTrueValue());
+            IntegerRange false_value = getValue(select->getFalseValue());
+            if (const APInt *cond_value = cond.getSingleElement()) {
+                return cond_value->isOneValue() ? true_value : false_value;
+            }
+            true_value.meet(false_value);
+            return true_value;
+        }
+        return IntegerRange::get(ConstantRange::getFull(width));
+    }
+
+    IntegerRange ValueRange::ValueOf(const Value &val) const {
+        if (!val.getType()->isIntegerTy()) {
+            return IntegerRange::overdefined();
+        }
+        if (const auto *constant = dyn_cast<ConstantInt>(&val)) {
+            return IntegerRange::get(ConstantRange(constant->getValue()));
+        }
+        // 函数参数, undef以及其他常量表达式
+        return IntegerRange::get(ConstantRange::getFull(val.getType()->getIntegerBitWidth()));
+    }
+
+    void ValueRange::FeasibleSuccessors(const Instruction &term, SmallVectorImpl<bool> &feasible) const {
+        const Value *cond = nullptr;
+        if (const auto *br = dyn_cast<BranchInst>(&term)) {
+            if (br->isConditional()) {
+                cond = br->getCondition();
+            }
+        } else if (const auto *sw = dyn_cast<SwitchInst>(&term)) {
+            cond = sw->getCondition();
+        }
+        if (cond == nullptr) {
+            std::fill(feasible.begin(), feasible.end(), true);
+            return;
+        }
+        IntegerRange value = getValue(cond);
+        if (value.isUndefined()) {
+            return;
+        }
+        const ConstantRange &range = value.getRange();
+        if (isa<BranchInst>(term)) {
+            if (const APInt *cond_value = range.getSingleElement()) {
+                // 条件为true时跳转到第0个后继
+                feasible[cond_value->isOneValue() ? 0 : 1] = true;
+            } else {
+                std::fill(feasible.begin(), feasible.end(), true);
+            }
+            return;
+        }
+        // switch: case的值在区间中时可执行; 区间中有不属于任何case的值时default可执行
+        const auto &sw = cast<SwitchInst>(term);
+        ConstantRange uncovered = range;
+        for (const auto &sw_case : sw.cases()) {
+            const APInt &case_value = sw_case.getCaseValue()->getValue();
+            if (range.contains(case_value)) {
+                feasible[sw_case.getSuccessorIndex()] = true;
+                uncovered = uncovered.difference(ConstantRange(case_value));
+            }
+        }
+        if (!uncovered.isEmptySet()) {
+            feasible[0] = true;
+        }
+    }
+
+    void ValueRange::Widen(const PHINode &phi, const IntegerRange &old_value, IntegerRange &value) const {
+        if (!old_value.isRange() || !value.isRange()) {
+            return;
+        }
+        const ConstantRange &old_range = old_value.getRange(), &range = value.getRange();
+        unsigned width = range.getBitWidth();
+        if (range.isSignWrappedSet()) {
+            value = IntegerRange::get(ConstantRange::getFull(width));
+            return;
+        }
+        APInt lower = range.getSignedMin(), upper = range.getSignedMax();
+        if (lower.slt(old_range.getSignedMin())) {
+            lower = APInt::getSignedMinValue(width);
+        }
+        if (upper.sgt(old_range.getSignedMax())) {
+            upper = APInt::getSignedMaxValue(width);
+        }
+        value = IntegerRange::get(ConstantRange::getNonEmpty(lower, upper + 1));
+    }
+
+    ConstantRange ValueRange::getRange(const Value *val) const {
+        unsigned width = val->getType()->getIntegerBitWidth();
+        if (const auto *inst = dyn_cast<Instruction>(val)) {
+            if (!isExecutable(*inst->getParent())) {
+                return ConstantRange::getEmpty(width);
+            }
+        }
+        IntegerRange value = getValue(val);
+        return value.isRange() ? value.getRange() : ConstantRange::getFull(width);
+    }
+
+    bool ValueRange::isKnownNonNegative(const Value *val) const {
+        if (const auto *inst = dyn_cast<Instruction>(val)) {
+            if (!isExecutable(*inst->getParent())) {
+                return false;
+            }
+        }
+        // IntegerRange::get保证Range一定非空
+        IntegerRange value = getValue(val);
+        return value.isRange() && value.getRange().isAllNonNegative();
+    }
+
+    ConstantInt *ValueRange::getConstant(const Instruction &inst) const {
+        if (!inst.getType()->isIntegerTy() || !isExecutable(*inst.getParent())) {
+            return nullptr;
+        }
+        const IntegerRange &value = getValue(inst);
+        const APInt *single = value.isRange() ? value.getRange().getSingleElement() : nullptr;
+        return single != nullptr ? ConstantInt::get(inst.getContext(), *single) : nullptr;
+    }
+}
@@ -0,0 +1,126 @@
+//
+// Created by sakura on 2026/10/17.
+//
+
+#ifndef ASSIGNMENT2_VALUE_RANGE_H
+#define ASSIGNMENT2_VALUE_RANGE_H
+
+#include <llvm/IR/ConstantRange.h>
+#include <llvm/IR/Constants.h>
+#include <llvm/IR/Instruction.h>
+#include <llvm/Support/raw_ostream.h>
+#include "lattice.h"
+
+namespace dfa {
+    /// Integer Range Lattice
+    ///
+    /// 整数区间的格: Undefined(Top, 还没有被执行到) > 区间 > 全集(Bottom). 区间用llvm::ConstantRange表示,
+    /// meet为两个区间的并(取不跨越有符号边界的那一种), 格的高度与位宽成指数关系, 需要在循环入口widening.
+    /// 不是整数的值(浮点, 指针等)不在这个格中, 用Overdefined表示.
+    class IntegerRange {
+    public:
+        enum Kind {
+            Undefined, Range, Overdefined
+        };
+    private:
+        Kind _kind = Undefined;
+        llvm::ConstantRange _range = llvm::ConstantRange::getEmpty(1);
+    public:
+        IntegerRange() = default;
+
+        /// @brief 区间@p range , 空区间(例如除以0的结果)表示该值不会被定义, 即Undefined
+        static IntegerRange get(const llvm::ConstantRange &range) {
+            IntegerRange value;
+            if (!range.isEmptySet()) {
+                value._kind = Range;
+                value._range = range;
+            }
+            return value;
+        }
+
+        static IntegerRange overdefined() {
+            IntegerRange value;
+            value._kind = Overdefined;
+            return value;
+        }
+
+        bool isUndefined() const { return _kind == Undefined; }
+
+        bool isRange() const { return _kind == Range; }
+
+        bool isOverdefined() const { return _kind == Overdefined; }
+
+        /// @brief 区间, 只有isRange()时有意义
+        const llvm::ConstantRange &getRange() const { return _range; }
+
+        bool meet(const IntegerRange &other) {
+            if (other._kind == Undefined || _kind == Overdefined || *this == other) {
+                return false;
+            }
+            if (_kind == Undefined || other._kind == Overdefined) {
+                *this = other;
+                return true;
+            }
+            llvm::ConstantRange range = _range.unionWith(other._range, llvm::ConstantRange::Signed);
+            if (range == _range) {
+                return false;
+            }
+            _range = range;
+            return true;
+        }
+
+        bool operator==(const IntegerRange &other) const {
+            return _kind == other._kind && (_kind != Range || _range == other._range);
+        }
+
+        bool operator!=(const IntegerRange &other) const { return !(*this == other); }
+
+        friend llvm::raw_ostream &operator<<(llvm::raw_ostream &outs, const IntegerRange &value) {
+            switch (value._kind) {
+                case Undefined:
+                    outs << "undefined";
+                    break;
+                case Range:
+                    value._range.print(outs);
+                    break;
+                case Overdefined:
+                    outs << "overdefined";
+                    break;
+            }
+            return outs;
+        }
+    };
+
+    /// Value Range Analysis
+    ///
+    /// 稀疏, 条件的整数区间分析: 每个整数值的区间由操作数的区间按指令的语义计算(带nsw/nuw的运算不会回绕),
+    /// 比较结果确定的icmp得到单个值的区间, 条件的区间只有一个值时分支只有一侧可执行.
+    /// 循环入口的phi在区间扩大时widening: 变小的下界直接放宽到有符号最小值, 变大的上界放宽到有符号最大值,
+    /// 所以每个phi的区间最多被放宽两次, 迭代总能终止.
+    /// 区间与程序点无关(SSA), 分支条件不会在两侧分别收窄操作数的区间.
+    class ValueRange final : public LatticeFramework<ValueRange, IntegerRange> {
+        typedef LatticeFramework<ValueRange, IntegerRange> base_t;
+        friend base_t;
+    protected:
+        IntegerRange Transfer(const Instruction &inst) const;
+
+        IntegerRange ValueOf(const Value &val) const;
+
+        void FeasibleSuccessors(const Instruction &term, SmallVectorImpl<bool> &feasible) const;
+
+        void Widen(const PHINode &phi, const IntegerRange &old_value, IntegerRange &value) const;
+
+    public:
+        /// @brief  整数值@p val 所有可能的取值. 不会被执行到的值为空集; 没有区间的值(Overdefined, 以及
+        ///         run()之后才创建, 分析没有见过的指令)为全集. 不是整数的值不能查询
+        llvm::ConstantRange getRange(const Value *val) const;
+
+        /// @brief  整数值@p val 是否一定非负. 只有分析得到了(非空的)区间时才可能为true,
+        ///         空集虽然isAllNonNegative(), 但不能作为改写的依据
+        bool isKnownNonNegative(const Value *val) const;
+
+        /// @brief 指令@p inst 的区间只有一个值时返回该常量, 例如结果确定的比较; 否则(或不可执行)返回nullptr
+        llvm::ConstantInt *getConstant(const Instruction &inst) const;
+    };
+}
+#endif //ASSIGNMENT2_VALUE_RANGE_H
@@ -2,11 +2,14 @@
 // Created by sakura on 2020/7/16.
 //
 
+#include <llvm/ADT/DenseMap.h>
 #include <llvm/Analysis/LoopPass.h>
 #include <llvm/Analysis/ValueTracking.h>
 #include <llvm/IR/Dominators.h>
 #include <llvm/IR/Instructions.h>
+#include <llvm/Support/CommandLine.h>
 #include <llvm/Support/raw_ostream.h>
+#include "register_pressure.h"
 
 using namespace llvm;
 
@@ -14,11 +17,22 @@ using namespace llvm;
     std::find(list.begin(), list.end(), elem) == list.end()
 
 namespace {
+    // 0表示不限制
+    cl::opt<unsigned> LICMPressureBudget(
+            "licm-pressure-budget", cl::init(0),
+            cl::desc("Do not hoist an invariant if the register pressure inside the loop would exceed this budget "
+                     "(0 = unlimited)"));
 
     class LoopInvariantCodeMotion final : public LoopPass {
     private:
         DominatorTree *dom_tree;  // owned by `DominatorTreeWrapperPass`
         std::list<Instruction *> MarkedAsInvariant;
+        // 只有设置了-licm-pressure-budget才计算. 每个函数只求解一次, 该函数的所有循环共用
+        dfa::RegisterPressure Pressure;
+        const Function *PressureFunction = nullptr;
+        // 每个程序点上已经移出的不变量中, Pressure不知道在那里活跃的个数. 移动只改变这些值的活跃范围,
+        // 所以程序点的实际压力不超过Pressure.getPressure() + ExtraPressure
+        DenseMap<const Instruction *, unsigned> ExtraPressure;
     public:
         static char ID;
 
@@ -32,6 +46,11 @@ namespace {
             AU.setPreservesCFG();
         }
 
+        virtual bool doFinalization() override {
+            releasePressure();
+            return false;
+        }
+
         /// @todo Finish the implementation of this method.
         virtual bool runOnLoop(Loop *L, LPPassManager &LPM) override {
             dom_tree = &(getAnalysis<DominatorTreeWrapperPass>().getDomTree());
@@ -68,6 +87,9 @@ namespace {
                     }
                 }
             } while (HasChanged);
+            if (LICMPressureBudget != 0) {
+                preparePressure(L);
+            }
             // 成功移动的指令个数
             int moveCount = 0;
             // 注意，要按照指令的顺序来判断与移动指令
@@ -80,6 +102,11 @@ namespace {
                         3. 循环中对语句s:x=y+z中，x的引用仅由s到达
                 */
                 if (isDomExitBlocks(Inst, L) && AssignOnce(Inst) && OneWayToReferences(Inst)) {
+                    // 移出去之后它在整个循环中都活跃, 可能把循环推到预算之上
+                    if (!fitsPressureBudget(Inst, L)) {
+                        outs() << "寄存器压力超出预算, 不移出: " << *Inst << "\n";
+                        continue;
+                    }
                     // 将指令移动到循环的前置首节点
                     moveToPreheader(Inst, L);
                     outs() << "移出循环的指令 " << moveCount << " : " << *Inst << "\n";
@@ -94,6 +121,70 @@ namespace {
             return IrHasChanged;
         }
 
+        void releasePressure() {
+            Pressure.release();
+            PressureFunction = nullptr;
+            ExtraPressure.clear();
+        }
+
+        // 确保Pressure是循环L所在函数的结果. 同一个函数的后续循环直接复用, 只有换了函数,
+        // 或者循环中出现了Pressure不认识的指令(其他pass在两次调用之间修改了IR)时才重新求解
+        void preparePressure(Loop *L) {
+            const Function *F = L->getHeader()->getParent();
+            bool Stale = PressureFunction != F;
+            for (BasicBlock *BB : L->blocks()) {
+                for (const Instruction &Inst : *BB) {
+                    if (!Stale && Pressure.getInstruction(Pressure.getIndex(Inst)) != &Inst) {
+                        Stale = true;
+                    }
+                }
+            }
+            if (Stale) {
+                releasePressure();
+                Pressure.run(*F);
+                PressureFunction = F;
+            }
+        }
+
+        // 对移出循环L之后Inst在其中新变得活跃的每个程序点调用fn: 移出去之后它从前置首节点的末尾一直活跃到它的最后一个use,
+        // 覆盖整个循环(回边), 所以是循环内所有原来它不活跃的点, 以及前置首节点的terminator.
+        // 它的操作数可能因此不再在循环内活跃, 这里保守地不计算这部分减少
+        template<class TFn>
+        void forEachNewlyLivePoint(Instruction *Inst, Loop *L, TFn fn) {
+            for (BasicBlock *BB : L->blocks()) {
+                for (const Instruction &Point : *BB) {
+                    if (!Pressure.isLiveAt(Inst, Point)) {
+                        fn(Point);
+                    }
+                }
+            }
+            const Instruction *Term = L->getLoopPreheader()->getTerminator();
+            if (!Pressure.isLiveAt(Inst, *Term)) {
+                fn(*Term);
+            }
+        }
+
+        // 检查把inst移到前置首节点之后, 它新变得活跃的每个点(加上之前移出的不变量)是否仍在预算之内, 是的话把它计入这些点的压力
+        bool fitsPressureBudget(Instruction *Inst, Loop *L) {
+            if (LICMPressureBudget == 0 || Inst->use_empty()) {
+                return true;
+            }
+            bool Fits = true;
+            forEachNewlyLivePoint(Inst, L, [&](const Instruction &Point) {
+                if (Pressure.getPressure(Point) + ExtraPressure.lookup(&Point) + 1 > LICMPressureBudget) {
+                    Fits = false;
+                }
+            });
+            if (!Fits) {
+                return false;
+            }
+            // 之后的不变量(包括外层循环的)在这些点上都要与它共存
+            forEachNewlyLivePoint(Inst, L, [&](const Instruction &Point) {
+                ++ExtraPressure[&Point];
+            });
+            return true;
+        }
+
         // 检查指令inst所在的基本块是否是循环所有exit节点的支配节点
         bool isDomExitBlocks(Instruction *Inst, Loop *L) {
             SmallVector<BasicBlock *, 0> exitBlock;